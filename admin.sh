@@ -4,10 +4,14 @@
 
 usage_help="
     -r, --recompile             [Default: false]    : if we want to recompile all source or not.
-    -m, --mode=...              [Default: none]     : 'train' or 'test' (or 'none')
+    -m, --mode=...              [Default: none]     : 'train' or 'test' (or 'none'). Also:
+                                                        - serve = run authentication server (tests are answered by it while it runs)
+                                                        - stop = stop running authentication server
+                                                        - listen = classify voice streamed to stdin as raw PCM16 samples, while it is streamed
+                                                          (e.g. 'python system/wav_record.py stream | ./admin.sh -m listen')
     --nb-mfcc=...               [Default: 13]       : number of mfcc coefficients (int).
     --nb-fbank=...              [Default: 26]       : number of filterbanks (int).
-    --reparse-wav               [Default: false]    : if we want to reparse all wav files (for train).
+    --reparse-wav               [Default: false]    : if we want to reparse new or changed wav files (for train). Delete data/train/features.manifest to reparse all.
     -n, --norm                  [Default: false]    : normilize audio file or not.
     --frame-window=...          [Default: 2.0]      : frame window in seconds to create train and test.
     --frame-step=...            [Default: 1.0]      : frame step in seconds to create train and test.
@@ -20,6 +24,14 @@ usage_help="
     --features-preprocess=...   [Default: 0]        : Features preprocess algorithm. Available:
                                                         - 0 = No preprocess
                                                         - 1 = Normalization (mean and std)
+    --features-engine=...       [Default: native]   : Features extraction engine. Available:
+                                                        - native = in-process C++ engine
+                                                        - python = reference python script (features.py)
+    --decision=...              [Default: all]      : When class of recorded voice is decided (native models only). Available:
+                                                        - all = vote of all frames
+                                                        - margin = as soon as one class has --decision-threshold more frames votes
+                                                        - llr = as soon as log-likelihood ratio of one class reaches --decision-threshold
+    --decision-threshold=...    [Default: 0]        : Threshold for 'margin' or 'llr' decision.
 "
 
 #################################################################################################################
@@ -118,7 +130,10 @@ function run_program_with_parameters(){
         ${parameters[one_vs_all]} \
         ${parameters[main_voice_class]} \
         ${parameters[model]} \
-        ${parameters[features_preprocess]}
+        ${parameters[features_preprocess]} \
+        ${parameters[features_engine]} \
+        ${parameters[decision]} \
+        ${parameters[decision_threshold]}
 }
 
 
@@ -143,6 +158,9 @@ parameters[main_voice_class]=1
 parameters[load_config]=0
 parameters[model]="NN"
 parameters[features_preprocess]=0
+parameters[features_engine]="native"
+parameters[decision]="all"
+parameters[decision_threshold]=0
 
 # declare some paths to be able to run scripts and etc 
 # (NOTE: need to sync with settings.h)
@@ -167,10 +185,10 @@ while :; do
             parameters[recompile]=1
             ;;
         -m)
-            check_and_change "mode" $2 "train" "test" "none"
+            check_and_change "mode" $2 "train" "test" "listen" "serve" "stop" "none"
             ;;
         --mode=?*|--mode=)
-            check_and_change "mode" ${1#*=} "train" "test" "none"
+            check_and_change "mode" ${1#*=} "train" "test" "listen" "serve" "stop" "none"
             ;;
         --nb-mfcc=?*|--nb-mfcc=)
             check_number_parameter "nb_mfcc" ${1#*=}
@@ -205,6 +223,15 @@ while :; do
         --features-preprocess=?*|--features-preprocess=)
             check_number_parameter "features_preprocess" ${1#*=}
             ;;
+        --features-engine=?*|--features-engine=)
+            check_and_change "features_engine" ${1#*=} "native" "python"
+            ;;
+        --decision=?*|--decision=)
+            check_and_change "decision" ${1#*=} "all" "margin" "llr"
+            ;;
+        --decision-threshold=?*|--decision-threshold=)
+            check_number_parameter "decision_threshold" ${1#*=}
+            ;;
         -?*)
             printf "ERROR: Unknown option: $1\n"
             exit
@@ -230,8 +257,14 @@ fi
 # if we need to recompile all source files
 if [[ ${parameters[recompile]} == 1 ]]; then
     echo 'SYS: Compiling...'
+    # use FFTW for features FFT if it is installed (see system/source/fft.h)
+    fftw_flags=""
+    if [ -f /usr/include/fftw3.h ]; then
+        fftw_flags="-DVAS_USE_FFTW -lfftw3"
+    fi
+
     g++ -std=c++11 system/main_interface.cpp \
-        -lboost_regex -lboost_filesystem -lboost_system -lm -pthread\
+        -lboost_regex -lboost_filesystem -lboost_system -lm -pthread $fftw_flags\
         -o system/executable
     printf "SYS: Done.\n"
 fi
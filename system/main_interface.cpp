@@ -7,21 +7,26 @@
 
 int main(int argc, char * argv[]){
 	std::string info = 	"Parameters:\n"
-						"  1)  mode      			('train' or 'test' or 'none')\n"
+						"  1)  mode      			('train' or 'test' or 'listen' or 'serve' or 'stop' or 'none'.\n"
+						"      						 'listen' - test voice streamed to stdin as raw PCM16 samples)\n"
 						"  2)  nb_mfcc   			(int, number of mfcc features)\n"
 						"  3)  nb_fbank  			(int, number of fbank features)\n"
-						"  4)  reparse   			('0' or '1'. Reparse all wav files ot not)\n"
+						"  4)  reparse   			('0' or '1'. Reparse new or changed wav files ot not)\n"
 						"  5)  normalize 			('0' or '1'. Normilize audio or not)\n"
 						"  6)  frame_window			(length of frame window for wav files parse)\n"
 						"  7)  frame_step			(length of frame step for wav files parse)\n"
 						"  8)  one-vs-all			('0' or '1'. Train model in one-vs-all mode or not)\n"
 						"  9)  main_voice_class		(number of main class (voice id) in one-vs-all train mode)\n"
 						" 10)  model 				(available model name: ['NN', 'RF'])\n"
-						" 11)  features_preprocess  (features preprocess algorithm. See more in python script)\n";
+						" 11)  features_preprocess  (features preprocess algorithm. See more in python script)\n"
+						" 12)  features_engine		(optional. 'native' (default) or 'python' (reference features.py script))\n"
+						" 13)  decision				(optional. 'all' (default, vote of all frames), 'margin' or 'llr' (decide as soon as\n"
+						"      						 votes margin or log-likelihood ratio reaches threshold, native models only))\n"
+						" 14)  decision_threshold	(optional. Threshold for 'margin' or 'llr' decision)\n";
 
 	try{
-		if(argc != 12){
-			std::cout << "NN:  Invalid number of parameters. Need 11 of them.\n" << info;
+		if(argc < 12 || argc > 15){
+			std::cout << "NN:  Invalid number of parameters. Need 11 (up to 14) of them.\n" << info;
 			return 1;
 		}
 
@@ -32,6 +37,9 @@ int main(int argc, char * argv[]){
 
 		bool train_mode = (strcmp(argv[1], "train") == 0);
 		bool test_mode = (strcmp(argv[1], "test") == 0);
+		bool listen_mode = (strcmp(argv[1], "listen") == 0);
+		bool serve_mode = (strcmp(argv[1], "serve") == 0);
+		bool stop_mode = (strcmp(argv[1], "stop") == 0);
 		int number_of_mfcc_features = std::stoi(argv[2]);
 		int number_of_fbank_features = std::stoi(argv[3]);
 		bool reparse_wav_files = strcmp(argv[4], "0") == 0 ? false : true;
@@ -42,6 +50,15 @@ int main(int argc, char * argv[]){
 		int main_voice_class = std::stoi(argv[9]);
 		std::string model_name = std::string(argv[10]);
 		FEATURES_PREPROCESS features_preprocess = static_cast<FEATURES_PREPROCESS>(std::stoi(argv[11]));
+		FEATURES_ENGINE features_engine = (argc > 12 && strcmp(argv[12], "python") == 0) ? FEATURES_ENGINE::PYTHON : FEATURES_ENGINE::NATIVE;
+		DECISION_RULE decision_rule = DECISION_RULE::ALL_FRAMES;
+		if(argc > 13 && strcmp(argv[13], "margin") == 0){
+			decision_rule = DECISION_RULE::VOTE_MARGIN;
+		}
+		else if(argc > 13 && strcmp(argv[13], "llr") == 0){
+			decision_rule = DECISION_RULE::LIKELIHOOD_RATIO;
+		}
+		double decision_threshold = argc > 14 ? std::stod(argv[14]) : 0.0;
 
 		
 		/*
@@ -60,6 +77,8 @@ int main(int argc, char * argv[]){
 			, main_voice_class
 			, features_preprocess
 			, main_voice_class
+			, features_engine
+			, DecisionParameters(decision_rule, decision_threshold)
 		);
 
 		// init current model directory
@@ -68,13 +87,11 @@ int main(int argc, char * argv[]){
 		) + "/";
 		boost::filesystem::create_directory(model_folder_path);
 
-		// reparse if we want to
-		if(!test_mode && reparse_wav_files){
-			clear_folder(SETTINGS::TRAIN_FILES_FEATURES_FOLDER);
-			ak.extract_features(SETTINGS::TRAIN_WAV_FILES_FOLDER, SETTINGS::TRAIN_FILES_FEATURES_FOLDER);
+		// reparse if we want to (only new or changed files, see features_manifest.h)
+		if(!test_mode && !listen_mode && !serve_mode && !stop_mode && reparse_wav_files){
+			ak.extract_features(SETTINGS::TRAIN_WAV_FILES_FOLDER, SETTINGS::TRAIN_FILES_FEATURES_FOLDER, SETTINGS::TRAIN_FILES_FEATURES_MANIFEST_PATH);
 			
-			clear_folder(SETTINGS::TEST_FILES_FEATURES_FOLDER);
-			ak.extract_features(SETTINGS::TEST_WAV_FILES_FOLDER, SETTINGS::TEST_FILES_FEATURES_FOLDER);
+			ak.extract_features(SETTINGS::TEST_WAV_FILES_FOLDER, SETTINGS::TEST_FILES_FEATURES_FOLDER, SETTINGS::TEST_FILES_FEATURES_MANIFEST_PATH);
 		}
 
 		if(train_mode){
@@ -82,7 +99,19 @@ int main(int argc, char * argv[]){
 			ak.fit(model_folder_path);
 		}
 		else if(test_mode){
-			ak.predict(model_folder_path);
+			// running server has everything loaded already
+			if(!ak.predict_with_server(model_folder_path)){
+				ak.predict(model_folder_path);
+			}
+		}
+		else if(listen_mode){
+			ak.predict_stream(STDIN_FILENO, model_folder_path);
+		}
+		else if(serve_mode){
+			ak.serve(model_folder_path);
+		}
+		else if(stop_mode){
+			std::cout << AuthenticationServer::send_request(SETTINGS::SERVER_SOCKET_PATH, "shutdown") << "\n";
 		}
 	}
 	catch(std::exception& e){
@@ -8,6 +8,16 @@ enum class FEATURES_PREPROCESS : int {
 };
 
 
+enum class FEATURES_ENGINE : int {
+	NATIVE, PYTHON		// in-process C++ engine or reference python script (features.py)
+};
+
+
+enum class DECISION_RULE : int {
+	ALL_FRAMES, VOTE_MARGIN, LIKELIHOOD_RATIO		// vote of all frames or early decision (see source/sequential_decision.h)
+};
+
+
 struct SETTINGS{
 	static std::string MAIN_FOLDER;								// path to VAS system folder
 	
@@ -20,13 +30,16 @@ struct SETTINGS{
 	static std::string TRAIN_DATA_FOLDER;						// path to folder containing folders with train wav files
 	static std::string TRAIN_WAV_FILES_FOLDER;					// path to folder with train wav files
 	static std::string TRAIN_FILES_FEATURES_FOLDER;				// path to folder with train wav files features
+	static std::string TRAIN_FILES_FEATURES_MANIFEST_PATH;		// filepath to manifest of train wav files features (see features_manifest.h)
 	static std::string TEST_DATA_FOLDER;						// path to folder containing folders with test wav files
 	static std::string TEST_WAV_FILES_FOLDER;					// path to folder with test wav files
 	static std::string TEST_FILES_FEATURES_FOLDER;				// path to folder with test wav files features
+	static std::string TEST_FILES_FEATURES_MANIFEST_PATH;		// filepath to manifest of test wav files features (see features_manifest.h)
 	
 	static std::string TEST_WAV_FILE_SAVE_PATH;					// filepath to store recorded (for testing) wav file
 	static std::string TEST_WAV_FEATURES_PATH;					// filepath to store features, extracted from testing wav file
 	static std::string TEST_WAV_PREDICTION_PATH;				// filepath to store result of classification
+	static std::string SERVER_SOCKET_PATH;						// unix socket of authentication server (see source/server.h)
 
 	static std::string PYTHON_FEATURES_SCRIPT_PATH;				// filepath to python script for extracting features
 	static std::string PYTHON_MODEL_TRAINING_SCRIPT_PATH;		// filepath to python script for training model
@@ -34,6 +47,7 @@ struct SETTINGS{
 	static std::string TRAIN_OUTPUT_NAME;						// filename for file with train data (without directory)
 	static std::string TEST_OUTPUT_NAME;						// filename for file with test data (without directory)
 	static std::string MODEL_DUMP_OUTPUT_NAME;					// filename for trained models dump (without directory)
+	static std::string NATIVE_MODEL_OUTPUT_NAME;				// filename for trained model exported for in-process evaluation (see source/native_model.h)
 
 	static std::string TRAIN_FILES_FILENAME_SUBSTRING;			// files with features with this substring in their names will be written into train sample
 	static std::string TEST_FILES_FILENAME_SUBSTRING;			// files with features with this substring in their names will be written into test sample
@@ -41,6 +55,7 @@ struct SETTINGS{
 	static std::string FEATURES_FILES_EXTENSION;				// extension of files containing wav files features
 
 	static int SAMPLE_RATE;										// sample rate of all wav files in system
+	static int MAX_STREAM_SECONDS;								// max length of audio streamed for testing (see 'listen' mode)
 };
 
 
@@ -55,20 +70,24 @@ std::string SETTINGS::GLOBAL_DATA_WAV_FILES_FOLDER				= SETTINGS::DATA_FOLDER
 std::string SETTINGS::TRAIN_DATA_FOLDER							= SETTINGS::DATA_FOLDER 			+ "train/";
 std::string SETTINGS::TRAIN_WAV_FILES_FOLDER					= SETTINGS::TRAIN_DATA_FOLDER		+ "data/";
 std::string SETTINGS::TRAIN_FILES_FEATURES_FOLDER				= SETTINGS::TRAIN_DATA_FOLDER		+ "features/";
+std::string SETTINGS::TRAIN_FILES_FEATURES_MANIFEST_PATH		= SETTINGS::TRAIN_DATA_FOLDER		+ "features.manifest";
 std::string SETTINGS::TEST_DATA_FOLDER							= SETTINGS::DATA_FOLDER				+ "test/";
 std::string SETTINGS::TEST_WAV_FILES_FOLDER						= SETTINGS::TEST_DATA_FOLDER		+ "data/";							
 std::string SETTINGS::TEST_FILES_FEATURES_FOLDER				= SETTINGS::TEST_DATA_FOLDER		+ "features/";
+std::string SETTINGS::TEST_FILES_FEATURES_MANIFEST_PATH			= SETTINGS::TEST_DATA_FOLDER		+ "features.manifest";
 
 std::string SETTINGS::TEST_WAV_FILE_SAVE_PATH					= SETTINGS::DATA_FOLDER				+ "_last_recorded.wav";
-std::string SETTINGS::TEST_WAV_FEATURES_PATH 					= SETTINGS::DATA_FOLDER 			+ "_last_recorded_wav_features.txt";
+std::string SETTINGS::TEST_WAV_FEATURES_PATH 					= SETTINGS::DATA_FOLDER 			+ "_last_recorded_wav.features";
 std::string SETTINGS::TEST_WAV_PREDICTION_PATH 					= SETTINGS::DATA_FOLDER 			+ "_last_recorded_wav_prediction.txt";
+std::string SETTINGS::SERVER_SOCKET_PATH 						= SETTINGS::DATA_FOLDER 			+ "_server.sock";
 
 std::string SETTINGS::PYTHON_FEATURES_SCRIPT_PATH				= SETTINGS::PYTHON_SCRIPTS_FOLDER	+ "features.py";
 std::string SETTINGS::PYTHON_MODEL_TRAINING_SCRIPT_PATH			= SETTINGS::PYTHON_SCRIPTS_FOLDER	+ "run_auth.py";
 
-std::string SETTINGS::TRAIN_OUTPUT_NAME							= "_train.txt";
-std::string SETTINGS::TEST_OUTPUT_NAME							= "_test.txt";
+std::string SETTINGS::TRAIN_OUTPUT_NAME							= "_train.dataset";
+std::string SETTINGS::TEST_OUTPUT_NAME							= "_test.dataset";
 std::string SETTINGS::MODEL_DUMP_OUTPUT_NAME					= "trained_model.dump";
+std::string SETTINGS::NATIVE_MODEL_OUTPUT_NAME					= "trained_model.native";
 
 std::string SETTINGS::TRAIN_FILES_FILENAME_SUBSTRING			= "part_train";
 std::string SETTINGS::TEST_FILES_FILENAME_SUBSTRING				= "part_test";
@@ -76,3 +95,4 @@ std::string SETTINGS::MAIN_WAV_FILE_FEATURES_FOLDER_PREFIX		= "voice_";
 std::string SETTINGS::FEATURES_FILES_EXTENSION					= ".features";
 
 int 		SETTINGS::SAMPLE_RATE								= 44100;
+int 		SETTINGS::MAX_STREAM_SECONDS						= 10;
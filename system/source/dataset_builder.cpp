@@ -0,0 +1,155 @@
+#include "dataset_builder.h"
+
+
+DatasetBuilder::DatasetBuilder(bool one_vs_all, int main_voice_class)
+	: one_vs_all_(one_vs_all)
+	, main_voice_class_(main_voice_class)
+{ }
+
+int DatasetBuilder::remap_class(int voice_class) const{
+	if(this->one_vs_all_){
+		return voice_class == this->main_voice_class_ ? 1 : 0;
+	}
+	return voice_class;
+}
+
+void DatasetBuilder::write_at(int file_descriptor, const void* data, size_t size, long long offset){
+	const char* bytes = static_cast<const char*>(data);
+
+	while(size > 0){
+		ssize_t written = pwrite(file_descriptor, bytes, size, offset);
+		if(written <= 0){
+			throw std::runtime_error("Can't write dataset file");
+		}
+		bytes += written;
+		size -= written;
+		offset += written;
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+void DatasetBuilder::add_file(const std::string& features_filepath, int voice_class){
+	DatasetPart part;
+	part.filepath = features_filepath;
+	part.label = this->remap_class(voice_class);
+	part.first_row = 0;
+	part.number_of_rows = 0;
+	this->parts_.push_back(part);
+}
+
+void DatasetBuilder::add_features_folder(const std::string& features_folder){
+	/*
+	*	Data in train or test is collected from all files with *.features signature.
+	*	Those files are stored separately in folders for each voice
+	*/
+
+	for(std::string& folder : get_directory_entries(features_folder, false)){
+		// get voice class (id) from folder name
+		int voice_class = std::stoi(std::string(folder.begin() + folder.find_last_of("_") + 1, folder.end()));
+
+		for(std::string& filepath : get_directory_entries(folder, true)){
+			// combine only files with features
+			size_t where_extension = filepath.find_last_of(".");
+			if(where_extension == std::string::npos || filepath.substr(where_extension) != SETTINGS::FEATURES_FILES_EXTENSION){
+				continue;
+			}
+			this->add_file(filepath, voice_class);
+		}
+	}
+}
+
+void DatasetBuilder::build(const std::string& output_filepath, int number_of_features, int nb_workers){
+	// dataset header: extraction parameters (same for all files) and total number of rows
+	FeaturesFileHeader dataset_header;
+	dataset_header.number_of_features = number_of_features;
+
+	long long total_rows = 0;
+	for(size_t index = 0; index < this->parts_.size(); ++index){
+		DatasetPart& part = this->parts_[index];
+		FeaturesFileHeader file_header = FeaturesFile::read_header(part.filepath);
+
+		if(index == 0){
+			dataset_header = file_header;
+		}
+		else if(file_header.number_of_features != dataset_header.number_of_features){
+			std::cout << "DatasetBuilder::build(...). Features file " << part.filepath << " has " << file_header.number_of_features << " features instead of " << dataset_header.number_of_features << "\n";
+			throw std::runtime_error("Features files have different number of features");
+		}
+
+		part.first_row = total_rows;
+		part.number_of_rows = file_header.number_of_frames;
+		total_rows += part.number_of_rows;
+	}
+
+	std::memcpy(dataset_header.magic, DATASET_FILE_MAGIC, sizeof(dataset_header.magic));
+	dataset_header.number_of_frames = total_rows;
+
+	long long row_size = sizeof(float) * static_cast<long long>(dataset_header.number_of_features);
+	long long labels_offset = sizeof(FeaturesFileHeader) + row_size * total_rows;
+
+	// dataset is written into temporary file, so old dataset is replaced only with complete one
+	std::string temporary_filepath = output_filepath + ".tmp";
+	int file_descriptor = open(temporary_filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if(file_descriptor < 0){
+		std::cout << "DatasetBuilder::build(...). Can't open file " << temporary_filepath << " for writing.\n";
+		throw std::runtime_error("Can't open file " + temporary_filepath);
+	}
+
+	std::atomic<size_t> next_part(0);
+	std::mutex m_errors_lock;
+	std::vector<std::string> errors;
+
+	auto thread_worker = [&](){
+		std::vector<int32_t> labels;
+
+		for(size_t index = next_part++; index < this->parts_.size(); index = next_part++){
+			const DatasetPart& part = this->parts_[index];
+			try{
+				FeaturesFile features_file(part.filepath);
+				if(features_file.get_number_of_frames() != part.number_of_rows){
+					throw std::runtime_error("Features file changed while building dataset: " + part.filepath);
+				}
+
+				write_at(file_descriptor, features_file.get_data(), row_size * part.number_of_rows, sizeof(FeaturesFileHeader) + row_size * part.first_row);
+
+				labels.assign(part.number_of_rows, part.label);
+				write_at(file_descriptor, labels.data(), sizeof(int32_t) * labels.size(), labels_offset + sizeof(int32_t) * part.first_row);
+			}
+			catch(std::exception& e){
+				std::lock_guard<std::mutex> lock(m_errors_lock);
+				errors.push_back(part.filepath + ": " + e.what());
+			}
+		}
+	};
+
+	std::vector<std::thread> workers;
+	int number_of_threads = std::max(1, std::min(nb_workers, static_cast<int>(this->parts_.size())));
+	for(int i = 0; i < number_of_threads; ++i){
+		workers.emplace_back(thread_worker);
+	}
+	for(auto& worker : workers){
+		worker.join();
+	}
+
+	try{
+		write_at(file_descriptor, &dataset_header, sizeof(FeaturesFileHeader), 0);
+	}
+	catch(std::exception& e){
+		errors.push_back(e.what());
+	}
+	close(file_descriptor);
+
+	if(!errors.empty()){
+		std::remove(temporary_filepath.c_str());
+		for(std::string& error : errors){
+			std::cout << "DatasetBuilder::build(...). " << error << "\n";
+		}
+		throw std::runtime_error("Can't build dataset " + output_filepath);
+	}
+
+	boost::filesystem::rename(temporary_filepath, output_filepath);
+}
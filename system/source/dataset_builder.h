@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "../settings.h"
+#include "features_file.h"
+#include "util.cpp"
+
+
+class DatasetBuilder{
+
+	/*
+	*	Builds train (or test) sample from features files: one dataset file (see features_file.h)
+	*	with all features rows one after another and class of each row.
+	*
+	*	First all files headers are read, so position of every file rows in dataset is known.
+	*	Then files are copied by several threads at once, each thread writes rows (and labels)
+	*	of its files right at their positions. Features files are memory mapped, so rows are
+	*	copied without any parsing.
+	*
+	*	Classes are remapped for one-vs-all classification while labels are written
+	*	(main voice class - '1', all others - '0').
+	*/
+
+private:
+
+	struct DatasetPart{
+		std::string filepath;					// features file
+		int label;								// class of all rows of file (already remapped)
+		long long first_row;					// position of file rows in dataset
+		long long number_of_rows;
+	};
+
+	bool one_vs_all_;							// remap classes for one-vs-all classification
+	int main_voice_class_;						// class which becomes '1' in one-vs-all mode
+	std::vector<DatasetPart> parts_;			// all files to write into dataset
+
+	// class as it is written into dataset
+	int remap_class(int voice_class) const;
+
+	// write all bytes at given position in file
+	static void write_at(int file_descriptor, const void* data, size_t size, long long offset);
+
+
+public:
+
+	DatasetBuilder(bool one_vs_all = false, int main_voice_class = -1);
+
+	// add features file with given voice class
+	void add_file(const std::string& features_filepath, int voice_class);
+
+	// add all features files from folder with 'voice_$_#' folders (# - voice class)
+	void add_features_folder(const std::string& features_folder);
+
+	// write dataset file. Number of features is used if there are no files at all
+	void build(const std::string& output_filepath, int number_of_features, int nb_workers = std::thread::hardware_concurrency());
+};
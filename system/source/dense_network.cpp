@@ -0,0 +1,135 @@
+#include "dense_network.h"
+
+
+const int DenseNetwork::ROWS_BLOCK = 64;
+const int DenseNetwork::INPUTS_BLOCK = 128;
+const int DenseNetwork::OUTPUTS_BLOCK = 256;
+
+
+DenseNetwork::DenseNetwork(const NativeModelHeader& header, std::istream& input)
+	: NativeModel(header, input)
+{
+	uint32_t number_of_layers;
+	read_values(input, &number_of_layers, 1);
+
+	int previous_dimension = header.input_dimension;
+	for(uint32_t index = 0; index < number_of_layers; ++index){
+		uint32_t description[4];
+		read_values(input, description, 4);
+
+		DenseLayer layer;
+		layer.input_dimension = description[0];
+		layer.output_dimension = description[1];
+		layer.activation = static_cast<ACTIVATION>(description[2]);
+
+		if(layer.input_dimension != previous_dimension || description[2] > static_cast<uint32_t>(ACTIVATION::TANH)){
+			throw std::runtime_error("Invalid layer " + std::to_string(index) + " of dense network");
+		}
+
+		layer.weights.resize(static_cast<size_t>(layer.input_dimension) * layer.output_dimension);
+		layer.biases.resize(layer.output_dimension);
+		read_values(input, layer.weights.data(), layer.weights.size());
+		read_values(input, layer.biases.data(), layer.biases.size());
+
+		previous_dimension = layer.output_dimension;
+		this->layers_.push_back(std::move(layer));
+	}
+
+	if(this->layers_.empty() || previous_dimension != static_cast<int>(header.number_of_classes)){
+		throw std::runtime_error("Dense network output does not match number of classes");
+	}
+}
+
+void DenseNetwork::evaluate_layer(const DenseLayer& layer, const float* input, long long number_of_rows, float* output){
+	int inputs = layer.input_dimension;
+	int outputs = layer.output_dimension;
+
+	for(long long first_row = 0; first_row < number_of_rows; first_row += ROWS_BLOCK){
+		long long last_row = std::min<long long>(first_row + ROWS_BLOCK, number_of_rows);
+
+		for(long long row = first_row; row < last_row; ++row){
+			std::copy(layer.biases.begin(), layer.biases.end(), output + row * outputs);
+		}
+
+		for(int first_input = 0; first_input < inputs; first_input += INPUTS_BLOCK){
+			int last_input = std::min(first_input + INPUTS_BLOCK, inputs);
+
+			for(int first_output = 0; first_output < outputs; first_output += OUTPUTS_BLOCK){
+				int block_outputs = std::min(OUTPUTS_BLOCK, outputs - first_output);
+
+				for(long long row = first_row; row < last_row; ++row){
+					const float* input_row = input + row * inputs;
+					float* output_row = output + row * outputs + first_output;
+
+					for(int input_index = first_input; input_index < last_input; ++input_index){
+						const float* weights_row = layer.weights.data() + static_cast<size_t>(input_index) * outputs + first_output;
+						SimdKernels::multiply_add(weights_row, block_outputs, input_row[input_index], output_row);
+					}
+				}
+			}
+		}
+	}
+
+	activate(layer.activation, output, number_of_rows, outputs);
+}
+
+void DenseNetwork::activate(ACTIVATION activation, float* rows, long long number_of_rows, int dimension){
+	long long size = number_of_rows * dimension;
+
+	switch(activation){
+		case ACTIVATION::LINEAR:
+			break;
+
+		case ACTIVATION::RELU:
+			for(long long index = 0; index < size; ++index){
+				rows[index] = std::max(rows[index], 0.0f);
+			}
+			break;
+
+		case ACTIVATION::SIGMOID:
+			for(long long index = 0; index < size; ++index){
+				rows[index] = 1.0f / (1.0f + std::exp(-rows[index]));
+			}
+			break;
+
+		case ACTIVATION::TANH:
+			for(long long index = 0; index < size; ++index){
+				rows[index] = std::tanh(rows[index]);
+			}
+			break;
+
+		case ACTIVATION::SOFTMAX:
+			for(long long row = 0; row < number_of_rows; ++row){
+				float* values = rows + row * dimension;
+				float max_value = *std::max_element(values, values + dimension);
+
+				float sum = 0.0f;
+				for(int index = 0; index < dimension; ++index){
+					values[index] = std::exp(values[index] - max_value);
+					sum += values[index];
+				}
+				for(int index = 0; index < dimension; ++index){
+					values[index] /= sum;
+				}
+			}
+			break;
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+void DenseNetwork::predict_proba(const float* rows, long long number_of_rows, float* output) const{
+	// outputs of previous and current layer
+	std::vector<float> current(rows, rows + number_of_rows * this->header_.input_dimension), next;
+
+	for(const DenseLayer& layer : this->layers_){
+		next.resize(number_of_rows * layer.output_dimension);
+		evaluate_layer(layer, current.data(), number_of_rows, next.data());
+		current.swap(next);
+	}
+
+	std::copy(current.begin(), current.end(), output);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "native_model.h"
+#include "simd_kernels.h"
+
+
+enum class ACTIVATION : int {
+	LINEAR, RELU, SIGMOID, SOFTMAX, TANH
+};
+
+
+class DenseNetwork : public NativeModel{
+
+	/*
+	*	Fully connected network (see scripts/models.py::NeuralNetModel,
+	*	Dense(relu) -> Dense(relu) -> Dense(sigmoid)), any number of layers.
+	*
+	*	Each layer is evaluated for a batch of rows at once - blocked matrix multiplication:
+	*	rows, inputs and outputs are split into blocks so weights block stays in cache
+	*	while it is applied to all rows of block. Innermost loop (SimdKernels::multiply_add)
+	*	goes along contiguous row of weights.
+	*
+	*	Model part of native model file: uint32 number of layers, then each layer:
+	*	 - uint32 input_dimension, output_dimension, activation (ACTIVATION), reserved
+	*	 - input_dimension x output_dimension float32 weights (keras kernel layout, row per input)
+	*	 - output_dimension float32 biases
+	*/
+
+private:
+
+	struct DenseLayer{
+		int input_dimension;
+		int output_dimension;
+		ACTIVATION activation;
+		std::vector<float> weights;				// input_dimension x output_dimension
+		std::vector<float> biases;
+	};
+
+	static const int ROWS_BLOCK;				// blocks of matrix multiplication
+	static const int INPUTS_BLOCK;
+	static const int OUTPUTS_BLOCK;
+
+	std::vector<DenseLayer> layers_;
+
+	// output = activation(input x weights + biases) for number_of_rows rows
+	static void evaluate_layer(const DenseLayer& layer, const float* input, long long number_of_rows, float* output);
+
+	// apply activation to each row (in place)
+	static void activate(ACTIVATION activation, float* rows, long long number_of_rows, int dimension);
+
+
+public:
+
+	// read model part of native model file (header sections are read by NativeModel)
+	DenseNetwork(const NativeModelHeader& header, std::istream& input);
+
+	void predict_proba(const float* rows, long long number_of_rows, float* output) const override;
+};
@@ -1,8 +1,38 @@
 #include "features.h"
 
 
-PoolFeaturesExtractor::PoolFeaturesExtractor(int nb_workers)
-	: nb_workers_(nb_workers)
+FileExtractionJob::FileExtractionJob(const std::string& set_wav_filepath, const std::string& set_output_filepath)
+	: wav_filepath(set_wav_filepath)
+	, output_filepath(set_output_filepath)
+	, number_of_frames(0)
+	, tasks_left(0)
+	, failed(false)
+{ }
+
+
+ExtractionTask::ExtractionTask(const std::string& set_wav_filepath, std::shared_ptr<FileExtractionJob> set_job, int set_first_frame, int set_last_frame)
+	: wav_filepath(set_wav_filepath)
+	, job(set_job)
+	, first_frame(set_first_frame)
+	, last_frame(set_last_frame)
+{ }
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Pool features extractor
+//----------------------------------------------------------------------------------------------------
+
+
+// ~10 seconds of audio per range task
+const long long PoolFeaturesExtractor::RANGE_TASK_SAMPLES = 441000;
+
+
+PoolFeaturesExtractor::PoolFeaturesExtractor(int nb_workers, FEATURES_ENGINE engine_type)
+	: engine_type_(engine_type)
+	, nb_workers_(std::max(1, nb_workers))
+	, pending_tasks_(0)
+	, files_left_(0)
 { }
 
 /*
@@ -18,37 +48,168 @@ void PoolFeaturesExtractor::run_python_feature_extractor(const std::vector<std::
 	run_python_script(SETTINGS::PYTHON_FEATURES_SCRIPT_PATH, parameters);
 }
 
-void PoolFeaturesExtractor::thread_worker(){
+void PoolFeaturesExtractor::push_task(int worker_index, const ExtractionTask& task){
+	// counted before it becomes visible, so no thread can see zero pending tasks while it is queued
+	++this->pending_tasks_;
+
+	WorkerQueue& queue = *this->queues_[worker_index];
+	std::lock_guard<std::mutex> lock(queue.lock);
+	queue.tasks.push_back(task);
+}
+
+bool PoolFeaturesExtractor::pop_task(int worker_index, ExtractionTask& task){
 	/*
-	*	One thread routine. Watching for files queue. While it is not empty - running
-	*	script to extract features. Using one global mutex for all threads (for queue).
+	*	Own deque is used as stack (back), others are robbed from the front -
+	*	oldest tasks there are the biggest ones (files are dealt biggest first).
 	*/
 
-	std::unique_lock<std::mutex> lock(this->m_files_storage_lock_);
+	{
+		WorkerQueue& own_queue = *this->queues_[worker_index];
+		std::lock_guard<std::mutex> lock(own_queue.lock);
+		if(!own_queue.tasks.empty()){
+			task = own_queue.tasks.back();
+			own_queue.tasks.pop_back();
+			return true;
+		}
+	}
 
-	while(!this->all_files_paths_.empty()){		
-		// get next file to extract features from
-		std::string filepath_to_proceed = this->all_files_paths_.front();
-		this->all_files_paths_.pop();
+	for(int shift = 1; shift < this->nb_workers_; ++shift){
+		WorkerQueue& victim_queue = *this->queues_[(worker_index + shift) % this->nb_workers_];
+		std::lock_guard<std::mutex> lock(victim_queue.lock);
+		if(!victim_queue.tasks.empty()){
+			task = victim_queue.tasks.front();
+			victim_queue.tasks.pop_front();
+			return true;
+		}
+	}
+
+	return false;
+}
 
-		// create parameters for python script. More info about parameters format see in script
-		std::vector<std::string> parameters;
+void PoolFeaturesExtractor::run_file_task(int worker_index, const std::string& wav_filepath){
+	std::string output_filepath = generate_features_output_filepath(wav_filepath);
+	int files_left = --this->files_left_;
 
-		// first two parameters - path to load from and save to
-		parameters.emplace_back(filepath_to_proceed);
-		parameters.emplace_back(generate_features_output_filepath(filepath_to_proceed));
+	{
+		std::lock_guard<std::mutex> lock(this->m_output_lock_);
+		std::cout << "THREAD ID: " << std::this_thread::get_id() << ". Files left: " << files_left << ". Proceeding file " << wav_filepath << std::endl;
+	}
 
-		// other script parameters (see more in script)
-		for(std::string& parameter : this->script_parameters_){
+	if(this->engine_type_ == FEATURES_ENGINE::PYTHON){
+		// first two parameters - path to load from and save to. More info about parameters format see in script
+		std::vector<std::string> parameters = {wav_filepath, output_filepath};
+		for(std::string& parameter : this->parameters_.to_script_parameters()){
 			parameters.emplace_back(parameter);
 		}
+		this->run_python_feature_extractor(parameters);
+		return;
+	}
 
-		std::cout << "THREAD ID: " << std::this_thread::get_id() << ". Files left: " << this->all_files_paths_.size() << ". Proceeding file " << filepath_to_proceed << std::endl;
+	int frames_per_task = static_cast<int>(std::max(1LL, RANGE_TASK_SAMPLES / this->parameters_.frame_step));
+	// estimated from file size (header size is not known before parsing chunks)
+	long long samples_in_file = (static_cast<long long>(boost::filesystem::file_size(wav_filepath)) - static_cast<long long>(sizeof(WavHeader))) / static_cast<long long>(sizeof(short));
 
-		// run current work without lock
-		lock.unlock();
-		this->run_python_feature_extractor(parameters);
-		lock.lock();
+	// short file - not worth splitting, streaming it with constant memory
+	if(this->engine_->get_number_of_frames(samples_in_file) <= 2 * frames_per_task){
+		this->engine_->extract_file(wav_filepath, output_filepath);
+		return;
+	}
+
+	std::shared_ptr<FileExtractionJob> job = std::make_shared<FileExtractionJob>(wav_filepath, output_filepath);
+	job->wav_file.load(wav_filepath, true);
+
+	if(!check_wav_file_format(job->wav_file.get_header())){
+		std::cout << "PoolFeaturesExtractor::run_file_task(...). Unsupported wav file format: " << wav_filepath << "\n";
+		throw std::runtime_error("Unsupported wav file format: " + wav_filepath);
+	}
+
+	AmplitudesView amplitudes = job->wav_file.get_amplitudes_view();
+	job->number_of_frames = this->engine_->get_number_of_frames(amplitudes.size);
+	job->features.resize(static_cast<size_t>(job->number_of_frames) * this->engine_->get_number_of_features());
+
+	int number_of_tasks = (job->number_of_frames + frames_per_task - 1) / frames_per_task;
+	job->tasks_left = number_of_tasks;
+
+	// all ranges except the first one are left for anybody to take, first one is done right here
+	for(int task_index = number_of_tasks - 1; task_index > 0; --task_index){
+		int first_frame = task_index * frames_per_task;
+		this->push_task(worker_index, ExtractionTask(wav_filepath, job, first_frame, std::min(job->number_of_frames, first_frame + frames_per_task)));
+	}
+	this->tasks_available_.notify_all();
+
+	this->run_range_task(ExtractionTask(wav_filepath, job, 0, std::min(job->number_of_frames, frames_per_task)));
+}
+
+void PoolFeaturesExtractor::run_range_task(const ExtractionTask& task){
+	FileExtractionJob& job = *task.job;
+
+	try{
+		if(!job.failed){
+			AmplitudesView amplitudes = job.wav_file.get_amplitudes_view();
+			double* output = job.features.data() + static_cast<size_t>(task.first_frame) * this->engine_->get_number_of_features();
+			this->engine_->extract_frames(amplitudes.data, amplitudes.size, task.first_frame, task.last_frame, output);
+		}
+	}
+	catch(std::exception& e){
+		job.failed = true;
+		std::lock_guard<std::mutex> lock(this->m_output_lock_);
+		std::cout << "PoolFeaturesExtractor::run_range_task(...). Exception while extracting features from " << job.wav_filepath << "\n";
+		std::cout << e.what() << '\n';
+	}
+
+	// last finished range writes whole file (file is unmapped when last task releases job)
+	if(--job.tasks_left != 0){
+		return;
+	}
+
+	if(job.failed){
+		std::lock_guard<std::mutex> lock(this->m_output_lock_);
+		this->failed_files_.push_back(job.wav_filepath);
+	}
+	else{
+		this->engine_->write_features(job.output_filepath, job.features.data(), job.number_of_frames);
+	}
+	std::vector<double>().swap(job.features);
+}
+
+void PoolFeaturesExtractor::thread_worker(int worker_index){
+	/*
+	*	One thread routine. Taking tasks from own deque (or stealing from others) until
+	*	there are no tasks queued or running. While some task is still running it may
+	*	add new range tasks, so idle thread waits a bit and checks again.
+	*/
+
+	while(true){
+		ExtractionTask task;
+
+		if(this->pop_task(worker_index, task)){
+			try{
+				if(task.job){
+					this->run_range_task(task);
+				}
+				else{
+					this->run_file_task(worker_index, task.wav_filepath);
+				}
+			}
+			catch(std::exception& e){
+				std::lock_guard<std::mutex> lock(this->m_output_lock_);
+				std::cout << "PoolFeaturesExtractor::thread_worker(). Exception while extracting features from " << task.wav_filepath << "\n";
+				std::cout << e.what() << '\n';
+				this->failed_files_.push_back(task.wav_filepath);
+			}
+
+			if(--this->pending_tasks_ == 0){
+				this->tasks_available_.notify_all();
+			}
+			continue;
+		}
+
+		if(this->pending_tasks_ == 0){
+			break;
+		}
+
+		std::unique_lock<std::mutex> lock(this->m_idle_lock_);
+		this->tasks_available_.wait_for(lock, std::chrono::milliseconds(1));
 	}
 }
 
@@ -62,22 +223,56 @@ int PoolFeaturesExtractor::get_nb_workers(){
 }
 
 void PoolFeaturesExtractor::add_file(const std::string& path_to_file){
-	this->all_files_paths_.push(path_to_file);
+	this->all_files_paths_.push_back(path_to_file);
 }
 
-void PoolFeaturesExtractor::extract(const std::vector<std::string>& parameters){
+void PoolFeaturesExtractor::extract(const FeaturesParameters& parameters){
 	// save parameters so all threads can read them
-	this->script_parameters_ = parameters;
+	this->parameters_ = parameters;
+
+	// build engine tables once for all threads
+	if(this->engine_type_ == FEATURES_ENGINE::NATIVE){
+		this->engine_.reset(new FeaturesEngine(parameters));
+	}
+
+	// biggest files first, dealt round robin between threads deques
+	std::vector<std::pair<long long, std::string>> files_by_size;
+	for(const std::string& filepath : this->all_files_paths_){
+		boost::system::error_code error;
+		long long file_size = static_cast<long long>(boost::filesystem::file_size(filepath, error));
+		files_by_size.emplace_back(error ? 0 : file_size, filepath);
+	}
+	std::stable_sort(files_by_size.begin(), files_by_size.end(), [](const std::pair<long long, std::string>& a, const std::pair<long long, std::string>& b){
+		return a.first > b.first;
+	});
+	this->all_files_paths_.clear();
+	this->failed_files_.clear();
+
+	this->queues_.clear();
+	for(int i = 0; i < this->nb_workers_; ++i){
+		this->queues_.emplace_back(new WorkerQueue());
+	}
+
+	this->files_left_ = files_by_size.size();
+	for(size_t i = 0; i < files_by_size.size(); ++i){
+		this->push_task(i % this->nb_workers_, ExtractionTask(files_by_size[i].second));
+	}
 
 	// run all threads
 	this->workers_.reserve(this->nb_workers_);
 
 	for(int i = 0; i < this->nb_workers_; ++i){
-		this->workers_.emplace_back(&PoolFeaturesExtractor::thread_worker, this);
+		this->workers_.emplace_back(&PoolFeaturesExtractor::thread_worker, this, i);
 	}
 
 	// wait for threads to finish
 	for(auto& worker : this->workers_){
 		worker.join();
 	}
+	this->workers_.clear();
+}
+
+std::vector<std::string> PoolFeaturesExtractor::get_failed_files(){
+	std::lock_guard<std::mutex> lock(this->m_output_lock_);
+	return this->failed_files_;
 }
@@ -1,53 +1,127 @@
 #pragma once
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <numeric>
-#include <queue>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include <boost/filesystem.hpp>
+
 #include "../settings.h"
+#include "features_engine.h"
 #include "util.cpp"
+#include "wav_file.h"
+
+
+struct FileExtractionJob{
+
+	/*
+	*	Long wav file which features are extracted by several frame range tasks.
+	*	Each task fills its own rows of 'features', thread finishing the last task
+	*	writes output file.
+	*/
+
+	std::string wav_filepath;						// file to extract features from
+	std::string output_filepath;					// file to save features to
+	WavFile wav_file;								// memory mapped wav file (shared by all range tasks, read-only)
+	int number_of_frames;							// total number of frames in file
+	std::vector<double> features;					// all features rows (row major, number_of_frames rows)
+	std::atomic<int> tasks_left;					// number of range tasks not finished yet
+	std::atomic<bool> failed;						// some range task failed - output is not written
+
+	FileExtractionJob(const std::string& set_wav_filepath, const std::string& set_output_filepath);
+};
+
+
+struct ExtractionTask{
+
+	/*
+	*	One unit of work for PoolFeaturesExtractor: either whole file (job is not set)
+	*	or range of frames [first_frame, last_frame) of long file.
+	*/
+
+	std::string wav_filepath;
+	std::shared_ptr<FileExtractionJob> job;
+	int first_frame;
+	int last_frame;
+
+	ExtractionTask(const std::string& set_wav_filepath = "", std::shared_ptr<FileExtractionJob> set_job = nullptr, int set_first_frame = 0, int set_last_frame = 0);
+};
 
 
 class PoolFeaturesExtractor{
 
 	/*
 	*	Thread pool to extract features from wav files.
-	*	
-	*	Features extraction procedure done via python scripts. This class manages
-	*	only multithread work for feature extraction.
-	*	
-	*	High-level idea: store all files paths that should be parsed in one queue
-	*	and run N threads to pick files from that queue. Those threads are running
-	*	python scripts, not the main thread.
+	*
+	*	Features extraction is done in-process by FeaturesEngine (one engine shared
+	*	by all threads). Reference python script (features.py) is still available
+	*	with FEATURES_ENGINE::PYTHON, e.g. to check native features against it.
+	*
+	*	High-level idea: work stealing. Every thread has its own deque of tasks (files are
+	*	dealt between threads, biggest first). Thread takes tasks from the back of its own deque,
+	*	when it is empty - steals from the front of other threads deques.
+	*	Long file (native engine only) is memory mapped and split into frame range tasks, which are
+	*	pushed into the deque of the thread which opened it, so idle threads can steal them and
+	*	all threads finish at about the same time instead of waiting for one long file.
 	*/
 
 private:
 
-	std::queue<std::string> all_files_paths_;		// accumulate all files that need to be parsed here
-	std::vector<std::string> script_parameters_;	// parameters for python script (see more in: py_features.py)
-	
+	struct WorkerQueue{
+		std::mutex lock;							// guards only this deque
+		std::deque<ExtractionTask> tasks;
+	};
+
+	static const long long RANGE_TASK_SAMPLES;		// approximate length of one frame range task (samples)
+
+	std::vector<std::string> all_files_paths_;		// accumulate all files that need to be parsed here
+	FEATURES_ENGINE engine_type_;					// extract features in-process or with python script
+	FeaturesParameters parameters_;					// features extraction parameters
+	std::unique_ptr<FeaturesEngine> engine_;		// native engine (shared by all threads, read-only)
+
 	// threads utils
 	int nb_workers_;								// number of threads (std::thread::hardware_concurrency)
 	std::vector<std::thread> workers_;				// saving all threads here
-	std::mutex m_files_storage_lock_;				// one global lock for files paths queue
+	std::vector<std::unique_ptr<WorkerQueue>> queues_;	// one tasks deque per thread
+	std::atomic<int> pending_tasks_;				// tasks queued or running (threads stop when it is zero)
+	std::atomic<int> files_left_;					// files not taken by any thread yet (for logging)
+	std::mutex m_idle_lock_;						// lock for idle threads waiting for new tasks
+	std::condition_variable tasks_available_;		// notified when range tasks are added or all work is done
+	std::mutex m_output_lock_;						// lock for std::cout (and failed_files_)
+	std::vector<std::string> failed_files_;			// files which features were not extracted
 
-	// python script (for extracting features) wrapper 
+	// python script (for extracting features) wrapper
 	void run_python_feature_extractor(const std::vector<std::string>& parameters);
 
-	// one thread routine (watching for queue and running python scripts)
-	void thread_worker();
+	// add task to given thread deque
+	void push_task(int worker_index, const ExtractionTask& task);
+
+	// take task from own deque or steal from others. False if all deques are empty
+	bool pop_task(int worker_index, ExtractionTask& task);
+
+	// extract features from whole file (long files are split into range tasks)
+	void run_file_task(int worker_index, const std::string& wav_filepath);
+
+	// extract features from range of frames of long file
+	void run_range_task(const ExtractionTask& task);
+
+	// one thread routine (taking tasks until all work is done)
+	void thread_worker(int worker_index);
 
 
 public:
 
-	PoolFeaturesExtractor(int nb_workers = std::thread::hardware_concurrency());
+	PoolFeaturesExtractor(int nb_workers = std::thread::hardware_concurrency(), FEATURES_ENGINE engine_type = FEATURES_ENGINE::NATIVE);
 
 	int get_nb_workers();
 
@@ -55,5 +129,8 @@ public:
 	void add_file(const std::string& path_to_file);
 
 	// extract features from all files that are in queue
-	void extract(const std::vector<std::string>& script_parameters);
+	void extract(const FeaturesParameters& parameters);
+
+	// files failed during last extract(...) call
+	std::vector<std::string> get_failed_files();
 };
@@ -0,0 +1,360 @@
+#include "features_engine.h"
+#include "fft.cpp"
+#include "simd_kernels.cpp"
+
+
+//----------------------------------------------------------------------------------------------------
+//	Features parameters
+//----------------------------------------------------------------------------------------------------
+
+
+FeaturesParameters::FeaturesParameters(
+	int set_frame_length
+	, int set_frame_step
+	, int set_number_of_mfcc_features
+	, int set_number_of_fbank_features
+	, bool set_normalize
+	, int set_sample_rate
+) :
+	frame_length(set_frame_length)
+	, frame_step(set_frame_step)
+	, number_of_mfcc_features(set_number_of_mfcc_features)
+	, number_of_fbank_features(set_number_of_fbank_features)
+	, normalize(set_normalize)
+	, sample_rate(set_sample_rate)
+{ }
+
+
+std::vector<std::string> FeaturesParameters::to_script_parameters() const{
+	/*
+	*	Order of parameters is fixed by features.py::extract_features(...)
+	*/
+
+	return {
+		std::to_string(this->frame_length)
+		, std::to_string(this->frame_step)
+		, std::to_string(this->number_of_fbank_features)
+		, std::to_string(this->number_of_mfcc_features)
+		, std::to_string(this->normalize)
+	};
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Mel filterbank
+//----------------------------------------------------------------------------------------------------
+
+
+MelFilterbank::MelFilterbank(int number_of_filters, int fft_size, int sample_rate, double low_frequency, double high_frequency){
+	/*
+	*	Same as python_speech_features.base.get_filterbanks(...):
+	*	filters edges are equally spaced on mel scale between low and high frequency,
+	*	edges are then rounded down to FFT bins.
+	*/
+
+	if(high_frequency <= 0.0){
+		high_frequency = sample_rate / 2.0;
+	}
+
+	double low_mel = hz_to_mel(low_frequency);
+	double high_mel = hz_to_mel(high_frequency);
+	double mel_step = (high_mel - low_mel) / (number_of_filters + 1);
+
+	std::vector<int> bins(number_of_filters + 2);
+	for(int point = 0; point < number_of_filters + 2; ++point){
+		double mel = (point == number_of_filters + 1) ? high_mel : low_mel + point * mel_step;
+		bins[point] = static_cast<int>(std::floor((fft_size + 1) * mel_to_hz(mel) / sample_rate));
+	}
+
+	this->first_bins.resize(number_of_filters);
+	this->weights.resize(number_of_filters);
+
+	for(int filter = 0; filter < number_of_filters; ++filter){
+		int left = bins[filter], center = bins[filter + 1], right = bins[filter + 2];
+
+		this->first_bins[filter] = left;
+		this->weights[filter].assign(std::max(0, right - left), 0.0);
+
+		for(int bin = left; bin < center; ++bin){
+			this->weights[filter][bin - left] = double(bin - left) / (center - left);
+		}
+		for(int bin = center; bin < right; ++bin){
+			this->weights[filter][bin - left] = double(right - bin) / (right - center);
+		}
+	}
+}
+
+int MelFilterbank::get_number_of_filters() const{
+	return this->first_bins.size();
+}
+
+void MelFilterbank::apply(const double* power_spectrum, double* output) const{
+	for(int filter = 0; filter < this->get_number_of_filters(); ++filter){
+		const double* spectrum = power_spectrum + this->first_bins[filter];
+		const std::vector<double>& filter_weights = this->weights[filter];
+
+		double energy = 0.0;
+		for(size_t index = 0; index < filter_weights.size(); ++index){
+			energy += spectrum[index] * filter_weights[index];
+		}
+
+		output[filter] = (energy == 0.0) ? std::numeric_limits<double>::epsilon() : energy;
+	}
+}
+
+double MelFilterbank::hz_to_mel(double hz){
+	return 2595.0 * std::log10(1.0 + hz / 700.0);
+}
+
+double MelFilterbank::mel_to_hz(double mel){
+	return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0);
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Features engine
+//----------------------------------------------------------------------------------------------------
+
+
+const double FeaturesEngine::LOW_FREQUENCY = 20.0;
+const double FeaturesEngine::HIGH_FREQUENCY = 20000.0;
+const double FeaturesEngine::PREEMPHASIS_COEFFICIENT = 0.97;
+const double FeaturesEngine::CEPSTRAL_LIFTER = 22.0;
+const int FeaturesEngine::FBANK_FFT_SIZE = 512;
+
+
+/*
+*	Constructor
+*/
+
+FeaturesEngine::FeaturesEngine(const FeaturesParameters& parameters)
+	: parameters_(parameters)
+	, mfcc_fft_(FFTPlanCache::get(parameters.frame_length))
+	, fbank_fft_(FFTPlanCache::get(FeaturesEngine::FBANK_FFT_SIZE))
+	, mfcc_filterbank_(parameters.number_of_mfcc_features, mfcc_fft_->get_size(), parameters.sample_rate, LOW_FREQUENCY, HIGH_FREQUENCY)
+	, fbank_filterbank_(parameters.number_of_fbank_features, fbank_fft_->get_size(), parameters.sample_rate, LOW_FREQUENCY, HIGH_FREQUENCY)
+	, amplitude_scale_(parameters.normalize ? 2.0 / 65536.0 : 1.0)
+	, amplitude_shift_(parameters.normalize ? -1.0 : 0.0)
+{
+	int frame_length = this->parameters_.frame_length;
+	int number_of_mfcc = this->parameters_.number_of_mfcc_features;
+
+	// numpy.hamming(M)
+	this->hamming_window_.resize(frame_length, 1.0);
+	if(frame_length > 1){
+		for(int index = 0; index < frame_length; ++index){
+			this->hamming_window_[index] = 0.54 - 0.46 * std::cos(2.0 * M_PI * index / (frame_length - 1));
+		}
+	}
+
+	// scipy.fftpack.dct(type=2, norm='ortho'), number of cepstral coeffs == number of filters
+	this->dct_matrix_.resize(number_of_mfcc * number_of_mfcc);
+	for(int k = 0; k < number_of_mfcc; ++k){
+		double scale = std::sqrt((k == 0 ? 1.0 : 2.0) / number_of_mfcc);
+		for(int n = 0; n < number_of_mfcc; ++n){
+			this->dct_matrix_[k * number_of_mfcc + n] = scale * std::cos(M_PI * k * (2 * n + 1) / (2.0 * number_of_mfcc));
+		}
+	}
+
+	// python_speech_features.base.lifter(...)
+	this->lifter_.resize(number_of_mfcc);
+	for(int n = 0; n < number_of_mfcc; ++n){
+		this->lifter_[n] = 1.0 + (CEPSTRAL_LIFTER / 2.0) * std::sin(M_PI * n / CEPSTRAL_LIFTER);
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+const FeaturesParameters& FeaturesEngine::get_parameters() const{
+	return this->parameters_;
+}
+
+int FeaturesEngine::get_number_of_features() const{
+	return this->parameters_.number_of_mfcc_features + this->parameters_.number_of_fbank_features;
+}
+
+int FeaturesEngine::get_number_of_frames(long long number_of_samples) const{
+	return count_frames(number_of_samples, this->parameters_.frame_length, this->parameters_.frame_step);
+}
+
+void FeaturesEngine::prepare_frame(const short* frame_samples, int valid_samples, const short* previous_sample, FeaturesWorkspace& workspace) const{
+	/*
+	*	Python preemphasizes whole signal and then zero pads it to fit the last frame,
+	*	so padded values stay zeros here too.
+	*
+	*	workspace.amplitudes = [previous sample, frame samples] as doubles (previous sample
+	*	is 0 for the first frame of signal, which leaves first sample as is).
+	*/
+
+	int frame_length = this->parameters_.frame_length;
+	valid_samples = std::max(0, std::min(valid_samples, frame_length));
+
+	workspace.frame.resize(frame_length);
+	workspace.amplitudes.resize(frame_length + 1);
+
+	workspace.amplitudes[0] = 0.0;
+	if(previous_sample != nullptr){
+		SimdKernels::convert_amplitudes(previous_sample, 1, this->amplitude_scale_, this->amplitude_shift_, workspace.amplitudes.data());
+	}
+	SimdKernels::convert_amplitudes(frame_samples, valid_samples, this->amplitude_scale_, this->amplitude_shift_, workspace.amplitudes.data() + 1);
+
+	SimdKernels::preemphasis(workspace.amplitudes.data(), valid_samples, PREEMPHASIS_COEFFICIENT, workspace.frame.data());
+	std::fill(workspace.frame.begin() + valid_samples, workspace.frame.end(), 0.0);
+}
+
+void FeaturesEngine::prepare_frame(const short* amplitudes, long long number_of_samples, int frame_index, FeaturesWorkspace& workspace) const{
+	long long frame_start = static_cast<long long>(frame_index) * this->parameters_.frame_step;
+	long long valid_samples = std::max(0LL, std::min<long long>(this->parameters_.frame_length, number_of_samples - frame_start));
+	const short* previous_sample = (frame_start > 0 && valid_samples > 0) ? amplitudes + frame_start - 1 : nullptr;
+
+	this->prepare_frame(amplitudes + std::min(frame_start, number_of_samples), valid_samples, previous_sample, workspace);
+}
+
+void FeaturesEngine::compute_frame(FeaturesWorkspace& workspace, double* output) const{
+	/*
+	*	Output row: [mfcc (nb_mfcc values), logfbank (nb_fbank values)]
+	*/
+
+	int frame_length = this->parameters_.frame_length;
+	int number_of_mfcc = this->parameters_.number_of_mfcc_features;
+	int number_of_fbank = this->parameters_.number_of_fbank_features;
+
+	workspace.power_spectrum.resize(std::max(this->mfcc_fft_->get_number_of_bins(), this->fbank_fft_->get_number_of_bins()));
+	workspace.filters_energies.resize(std::max(number_of_mfcc, number_of_fbank));
+
+	// mfcc (hamming window)
+	if(number_of_mfcc > 0){
+		workspace.windowed_frame.resize(frame_length);
+		SimdKernels::multiply(workspace.frame.data(), this->hamming_window_.data(), frame_length, workspace.windowed_frame.data());
+
+		this->mfcc_fft_->power_spectrum(workspace.windowed_frame.data(), frame_length, workspace.power_spectrum.data(), workspace.fft_buffer);
+
+		double frame_energy = 0.0;
+		for(int bin = 0; bin < this->mfcc_fft_->get_number_of_bins(); ++bin){
+			frame_energy += workspace.power_spectrum[bin];
+		}
+		if(frame_energy == 0.0){
+			frame_energy = std::numeric_limits<double>::epsilon();
+		}
+
+		this->mfcc_filterbank_.apply(workspace.power_spectrum.data(), workspace.filters_energies.data());
+		for(int filter = 0; filter < number_of_mfcc; ++filter){
+			workspace.filters_energies[filter] = std::log(workspace.filters_energies[filter]);
+		}
+
+		for(int k = 0; k < number_of_mfcc; ++k){
+			const double* dct_row = this->dct_matrix_.data() + k * number_of_mfcc;
+			double value = 0.0;
+			for(int n = 0; n < number_of_mfcc; ++n){
+				value += dct_row[n] * workspace.filters_energies[n];
+			}
+			output[k] = value * this->lifter_[k];
+		}
+
+		// appendEnergy=True
+		output[0] = std::log(frame_energy);
+	}
+
+	// logfbank (no window)
+	if(number_of_fbank > 0){
+		this->fbank_fft_->power_spectrum(workspace.frame.data(), frame_length, workspace.power_spectrum.data(), workspace.fft_buffer);
+		this->fbank_filterbank_.apply(workspace.power_spectrum.data(), workspace.filters_energies.data());
+
+		for(int filter = 0; filter < number_of_fbank; ++filter){
+			output[number_of_mfcc + filter] = std::log(workspace.filters_energies[filter]);
+		}
+	}
+}
+
+std::vector<std::vector<double>> FeaturesEngine::extract(const short* amplitudes, long long number_of_samples) const{
+	int number_of_frames = this->get_number_of_frames(number_of_samples);
+
+	std::vector<std::vector<double>> features(number_of_frames, std::vector<double>(this->get_number_of_features()));
+	FeaturesWorkspace workspace;
+
+	for(int frame_index = 0; frame_index < number_of_frames; ++frame_index){
+		this->prepare_frame(amplitudes, number_of_samples, frame_index, workspace);
+		this->compute_frame(workspace, features[frame_index].data());
+	}
+
+	return features;
+}
+
+void FeaturesEngine::extract_frames(const short* amplitudes, long long number_of_samples, int first_frame, int last_frame, double* output) const{
+	/*
+	*	Frames are independent from each other, so any range of frames can be extracted
+	*	separately (e.g. by different threads, see PoolFeaturesExtractor)
+	*/
+
+	int number_of_features = this->get_number_of_features();
+	FeaturesWorkspace workspace;
+
+	for(int frame_index = first_frame; frame_index < last_frame; ++frame_index){
+		this->prepare_frame(amplitudes, number_of_samples, frame_index, workspace);
+		this->compute_frame(workspace, output + static_cast<long long>(frame_index - first_frame) * number_of_features);
+	}
+}
+
+void FeaturesEngine::extract_file(const std::string& wav_filepath, const std::string& output_filepath) const{
+	/*
+	*	Replacement for one features.py run. Wav file should be in system format
+	*	(see util.cpp::check_wav_file_format).
+	*
+	*	File is streamed frame by frame (see WavFrameReader) and each features row is written
+	*	right after it is computed, so memory used does not depend on recording length.
+	*/
+
+	WavFrameReader frames_reader(wav_filepath, this->parameters_.frame_length, this->parameters_.frame_step);
+
+	if(!check_wav_file_format(frames_reader.get_header())){
+		std::cout << "FeaturesEngine::extract_file(...). Unsupported wav file format: " << wav_filepath << "\n";
+		throw std::runtime_error("Unsupported wav file format: " + wav_filepath);
+	}
+
+	FeaturesFileWriter writer(output_filepath, this->get_file_header());
+
+	FeaturesWorkspace workspace;
+	FrameSamples frame;
+	std::vector<double> features_row(this->get_number_of_features());
+
+	while(frames_reader.next_frame(frame)){
+		this->prepare_frame(frame.samples.data(), frame.valid_samples, frame.has_previous ? &frame.previous_sample : nullptr, workspace);
+		this->compute_frame(workspace, features_row.data());
+		writer.write_row(features_row.data());
+	}
+
+	writer.close();
+}
+
+FeaturesFileHeader FeaturesEngine::get_file_header() const{
+	FeaturesFileHeader header;
+	header.number_of_features = this->get_number_of_features();
+	header.number_of_mfcc_features = this->parameters_.number_of_mfcc_features;
+	header.number_of_fbank_features = this->parameters_.number_of_fbank_features;
+	header.frame_length = this->parameters_.frame_length;
+	header.frame_step = this->parameters_.frame_step;
+	header.sample_rate = this->parameters_.sample_rate;
+	header.normalize = this->parameters_.normalize ? 1 : 0;
+	return header;
+}
+
+void FeaturesEngine::write_features(const std::string& output_filepath, const std::vector<std::vector<double>>& features) const{
+	FeaturesFileWriter writer(output_filepath, this->get_file_header());
+	for(const std::vector<double>& row : features){
+		writer.write_row(row.data());
+	}
+	writer.close();
+}
+
+void FeaturesEngine::write_features(const std::string& output_filepath, const double* features, int number_of_rows) const{
+	FeaturesFileWriter writer(output_filepath, this->get_file_header());
+	for(int row = 0; row < number_of_rows; ++row){
+		writer.write_row(features + static_cast<long long>(row) * this->get_number_of_features());
+	}
+	writer.close();
+}
@@ -0,0 +1,173 @@
+#pragma once
+
+#include <cmath>
+#include <complex>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../settings.h"
+#include "features_file.h"
+#include "fft.h"
+#include "simd_kernels.h"
+#include "util.cpp"
+#include "wav_file.h"
+
+
+struct FeaturesParameters{
+
+	/*
+	*	Parameters of features extraction routine. Same set of parameters
+	*	as python features script gets (see scripts/features.py).
+	*/
+
+	int frame_length;						// length of one frame (number of samples)
+	int frame_step;							// step between frames (number of samples)
+	int number_of_mfcc_features;			// number of mfcc coeffs (and mel filters for mfcc)
+	int number_of_fbank_features;			// number of log filterbank coeffs
+	bool normalize;							// normalize amplitudes or not (see utilities.py::normilize_wav)
+	int sample_rate;						// sample rate of wav files
+
+
+public:
+
+	FeaturesParameters(
+		int set_frame_length = 0
+		, int set_frame_step = 0
+		, int set_number_of_mfcc_features = 13
+		, int set_number_of_fbank_features = 26
+		, bool set_normalize = false
+		, int set_sample_rate = SETTINGS::SAMPLE_RATE
+	);
+
+	// parameters in python features script format (without input and output paths)
+	std::vector<std::string> to_script_parameters() const;
+};
+
+
+struct MelFilterbank{
+
+	/*
+	*	Triangular mel filters (python_speech_features.base.get_filterbanks).
+	*	Each filter is stored only by its non zero weights: first bin index and weights
+	*	starting from that bin. So even for long FFT filterbank takes ~N/2 values in total.
+	*/
+
+	std::vector<int> first_bins;					// index of first non zero bin for each filter
+	std::vector<std::vector<double>> weights;		// non zero weights for each filter
+
+
+public:
+
+	MelFilterbank(int number_of_filters = 0, int fft_size = 512, int sample_rate = 44100, double low_frequency = 0.0, double high_frequency = 0.0);
+
+	int get_number_of_filters() const;
+
+	// filters energies (zeros are replaced with machine epsilon, as python does)
+	void apply(const double* power_spectrum, double* output) const;
+
+	static double hz_to_mel(double hz);
+	static double mel_to_hz(double mel);
+};
+
+
+struct FeaturesWorkspace{
+
+	/*
+	*	Per-thread buffers for FeaturesEngine. Engine itself is read-only while
+	*	extracting, so all mutable state lives here.
+	*/
+
+	std::vector<double> amplitudes;						// frame amplitudes (with previous sample) as doubles
+	std::vector<double> frame;							// preemphasized frame (zero padded)
+	std::vector<double> windowed_frame;					// frame after window function
+	std::vector<double> power_spectrum;					// power spectrum of current frame
+	std::vector<double> filters_energies;				// mel filterbank output
+	FFTBuffer fft_buffer;								// FFT scratch buffer
+};
+
+
+class FeaturesEngine{
+
+	/*
+	*	In-process replacement for scripts/features.py. Produces same features:
+	*	mfcc (hamming window) and logfbank (no window) over the same frames, concatenated
+	*	in one row per frame.
+	*
+	*	Mirrors python_speech_features (0.6) behaviour, including its defaults:
+	*	 - preemphasis 0.97, cepstral lifter 22, first cepstral coeff replaced with log frame energy
+	*	 - mfcc FFT size is the next power of two not less than frame length
+	*	 - logfbank FFT size is 512 (longer frames are truncated, as numpy.fft.rfft does)
+	*
+	*	All tables (window, filterbanks, DCT matrix) are built once in constructor, FFT plans
+	*	are shared with all other engines through FFTPlanCache.
+	*	Engine is not modified while extracting, so one engine can be shared between threads.
+	*/
+
+private:
+
+	static const double LOW_FREQUENCY;				// lowest band edge of mel filters (features.py: lowfreq)
+	static const double HIGH_FREQUENCY;				// highest band edge of mel filters (features.py: highfreq)
+	static const double PREEMPHASIS_COEFFICIENT;	// python_speech_features default
+	static const double CEPSTRAL_LIFTER;			// python_speech_features default
+	static const int FBANK_FFT_SIZE;				// python_speech_features.logfbank default nfft
+
+	FeaturesParameters parameters_;
+
+	std::shared_ptr<const RealFFT> mfcc_fft_;		// FFT for mfcc features (from FFTPlanCache)
+	std::shared_ptr<const RealFFT> fbank_fft_;		// FFT for log filterbank features (from FFTPlanCache)
+	MelFilterbank mfcc_filterbank_;					// nb_mfcc filters over mfcc FFT bins
+	MelFilterbank fbank_filterbank_;				// nb_fbank filters over fbank FFT bins
+	std::vector<double> hamming_window_;			// numpy.hamming(frame_length)
+	std::vector<double> dct_matrix_;				// orthonormal DCT-II (row major, nb_mfcc x nb_mfcc)
+	std::vector<double> lifter_;					// cepstral lifter coeffs
+
+	// amplitude value as python gets it: amplitude * scale + shift (see utilities.py::normilize_wav)
+	double amplitude_scale_;
+	double amplitude_shift_;
+
+
+public:
+
+	FeaturesEngine(const FeaturesParameters& parameters);
+
+	const FeaturesParameters& get_parameters() const;
+
+	// number of values in one features row (nb_mfcc + nb_fbank)
+	int get_number_of_features() const;
+
+	// number of frames for signal of given length (python_speech_features.sigproc.framesig)
+	int get_number_of_frames(long long number_of_samples) const;
+
+	// normalize and preemphasize frame samples, store result in workspace.frame
+	// (samples after valid_samples are zero padding; previous_sample is nullptr for the first frame)
+	void prepare_frame(const short* frame_samples, int valid_samples, const short* previous_sample, FeaturesWorkspace& workspace) const;
+
+	// same for frame with given index in whole signal
+	void prepare_frame(const short* amplitudes, long long number_of_samples, int frame_index, FeaturesWorkspace& workspace) const;
+
+	// features for workspace.frame (output should have get_number_of_features() values)
+	void compute_frame(FeaturesWorkspace& workspace, double* output) const;
+
+	// features for all frames of signal
+	std::vector<std::vector<double>> extract(const short* amplitudes, long long number_of_samples) const;
+
+	// features for frames [first_frame, last_frame) of signal, rows are written one after another into output
+	void extract_frames(const short* amplitudes, long long number_of_samples, int first_frame, int last_frame, double* output) const;
+
+	// header of features file with current parameters (see features_file.h)
+	FeaturesFileHeader get_file_header() const;
+
+	// read wav file frame by frame, extract features and save them as features file (see features_file.h)
+	void extract_file(const std::string& wav_filepath, const std::string& output_filepath) const;
+
+	// write features rows as features file (see features_file.h)
+	void write_features(const std::string& output_filepath, const std::vector<std::vector<double>>& features) const;
+
+	// same for rows stored one after another in one array
+	void write_features(const std::string& output_filepath, const double* features, int number_of_rows) const;
+};
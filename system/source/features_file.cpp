@@ -0,0 +1,166 @@
+#include "features_file.h"
+
+
+const char FEATURES_FILE_MAGIC[4] = {'V', 'A', 'S', 'F'};
+const char DATASET_FILE_MAGIC[4] = {'V', 'A', 'S', 'D'};
+const uint32_t FEATURES_FILE_VERSION = 1;
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Features file header
+//----------------------------------------------------------------------------------------------------
+
+
+FeaturesFileHeader::FeaturesFileHeader(){
+	std::memset(this, 0, sizeof(FeaturesFileHeader));
+	std::memcpy(this->magic, FEATURES_FILE_MAGIC, sizeof(this->magic));
+	this->version = FEATURES_FILE_VERSION;
+}
+
+bool FeaturesFileHeader::is_valid(const char* expected_magic) const{
+	return std::memcmp(this->magic, expected_magic, sizeof(this->magic)) == 0 && this->version == FEATURES_FILE_VERSION;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Features file writer
+//----------------------------------------------------------------------------------------------------
+
+
+FeaturesFileWriter::FeaturesFileWriter(const std::string& filepath, const FeaturesFileHeader& header)
+	: filepath_(filepath)
+	, output_(filepath, std::ios::binary)
+	, header_(header)
+	, row_buffer_(header.number_of_features)
+{
+	if(!this->output_.is_open()){
+		std::cout << "FeaturesFileWriter::FeaturesFileWriter(...). Can't open file " << filepath << " for writing.\n";
+		throw std::runtime_error("Can't open file " + filepath);
+	}
+
+	// placeholder until number of frames is known
+	this->header_.number_of_frames = 0;
+	this->output_.write(reinterpret_cast<const char*>(&this->header_), sizeof(FeaturesFileHeader));
+}
+
+FeaturesFileWriter::~FeaturesFileWriter(){
+	// not closed - writing was interrupted (e.g. by exception), half written file should not be used
+	if(this->output_.is_open()){
+		this->output_.close();
+		std::remove(this->filepath_.c_str());
+	}
+}
+
+void FeaturesFileWriter::write_row(const double* row){
+	for(size_t index = 0; index < this->row_buffer_.size(); ++index){
+		this->row_buffer_[index] = static_cast<float>(row[index]);
+	}
+	this->write_rows(this->row_buffer_.data(), 1);
+}
+
+void FeaturesFileWriter::write_rows(const float* rows, long long number_of_rows){
+	this->output_.write(reinterpret_cast<const char*>(rows), sizeof(float) * this->header_.number_of_features * number_of_rows);
+	this->header_.number_of_frames += number_of_rows;
+}
+
+void FeaturesFileWriter::close(){
+	if(!this->output_.is_open()){
+		return;
+	}
+
+	this->output_.seekp(0);
+	this->output_.write(reinterpret_cast<const char*>(&this->header_), sizeof(FeaturesFileHeader));
+	this->output_.close();
+
+	if(this->output_.fail()){
+		throw std::runtime_error("Can't write file " + this->filepath_);
+	}
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Features file (memory mapped)
+//----------------------------------------------------------------------------------------------------
+
+
+FeaturesFile::FeaturesFile(const std::string& filepath, const char* expected_magic)
+	: mapped_file_(nullptr)
+	, mapped_size_(0)
+{
+	int file_descriptor = open(filepath.c_str(), O_RDONLY);
+	if(file_descriptor < 0){
+		std::cout << "FeaturesFile::FeaturesFile(...). Can't open file " << filepath << "\n";
+		throw std::runtime_error("Can't open file " + filepath);
+	}
+
+	struct stat file_info;
+	if(fstat(file_descriptor, &file_info) != 0 || file_info.st_size < static_cast<off_t>(sizeof(FeaturesFileHeader))){
+		close(file_descriptor);
+		std::cout << "FeaturesFile::FeaturesFile(...). File is too small to be features file: " << filepath << "\n";
+		throw std::runtime_error("File is too small to be features file: " + filepath);
+	}
+
+	void* region = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+
+	if(region == MAP_FAILED){
+		std::cout << "FeaturesFile::FeaturesFile(...). Can't map file " << filepath << "\n";
+		throw std::runtime_error("Can't map file " + filepath);
+	}
+
+	this->mapped_file_ = static_cast<char*>(region);
+	this->mapped_size_ = file_info.st_size;
+	std::memcpy(&this->header_, this->mapped_file_, sizeof(FeaturesFileHeader));
+
+	size_t expected_size = sizeof(FeaturesFileHeader) + sizeof(float) * this->header_.number_of_features * this->header_.number_of_frames;
+	if(std::memcmp(expected_magic, DATASET_FILE_MAGIC, sizeof(this->header_.magic)) == 0){
+		expected_size += sizeof(int32_t) * this->header_.number_of_frames;
+	}
+
+	if(!this->header_.is_valid(expected_magic) || this->mapped_size_ < expected_size){
+		munmap(this->mapped_file_, this->mapped_size_);
+		std::cout << "FeaturesFile::FeaturesFile(...). Invalid features file: " << filepath << "\n";
+		throw std::runtime_error("Invalid features file: " + filepath);
+	}
+
+	madvise(this->mapped_file_, this->mapped_size_, MADV_SEQUENTIAL);
+}
+
+FeaturesFile::~FeaturesFile(){
+	munmap(this->mapped_file_, this->mapped_size_);
+}
+
+const FeaturesFileHeader& FeaturesFile::get_header() const{
+	return this->header_;
+}
+
+long long FeaturesFile::get_number_of_frames() const{
+	return this->header_.number_of_frames;
+}
+
+int FeaturesFile::get_number_of_features() const{
+	return this->header_.number_of_features;
+}
+
+const float* FeaturesFile::get_data() const{
+	return reinterpret_cast<const float*>(this->mapped_file_ + sizeof(FeaturesFileHeader));
+}
+
+const int32_t* FeaturesFile::get_labels() const{
+	return reinterpret_cast<const int32_t*>(this->get_data() + this->header_.number_of_features * this->header_.number_of_frames);
+}
+
+FeaturesFileHeader FeaturesFile::read_header(const std::string& filepath, const char* expected_magic){
+	FeaturesFileHeader header;
+
+	std::ifstream inf(filepath, std::ios::binary);
+	if(!inf.read(reinterpret_cast<char*>(&header), sizeof(FeaturesFileHeader)) || !header.is_valid(expected_magic)){
+		std::cout << "FeaturesFile::read_header(...). Invalid features file: " << filepath << "\n";
+		throw std::runtime_error("Invalid features file: " + filepath);
+	}
+
+	return header;
+}
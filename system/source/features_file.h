@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+struct FeaturesFileHeader{
+
+	/*
+	*	Header of binary features file. Whole file is:
+	*	 - this header (48 bytes, little endian)
+	*	 - number_of_frames x number_of_features float32 values (row major, one row per frame)
+	*	 - dataset files only (see dataset_builder.h): number_of_frames int32 labels
+	*
+	*	Same layout is read and written by python scripts (see scripts/utilities.py).
+	*/
+
+	char magic[4];									// FEATURES_FILE_MAGIC or DATASET_FILE_MAGIC
+	uint32_t version;								// FEATURES_FILE_VERSION
+	uint32_t number_of_features;					// values in one row (nb_mfcc + nb_fbank)
+	uint32_t number_of_mfcc_features;				// extraction parameters ...
+	uint32_t number_of_fbank_features;
+	uint32_t frame_length;
+	uint32_t frame_step;
+	uint32_t sample_rate;
+	uint32_t normalize;								// ... (0 or 1)
+	uint32_t reserved;								// zero (keeps number_of_frames 8 byte aligned)
+	uint64_t number_of_frames;						// number of rows
+
+
+	FeaturesFileHeader();
+
+	// check magic and version
+	bool is_valid(const char* expected_magic) const;
+};
+
+static_assert(sizeof(FeaturesFileHeader) == 48, "FeaturesFileHeader layout is shared with python scripts");
+
+
+extern const char FEATURES_FILE_MAGIC[4];			// features of one wav file
+extern const char DATASET_FILE_MAGIC[4];			// train or test sample (features rows of many files + labels)
+extern const uint32_t FEATURES_FILE_VERSION;
+
+
+class FeaturesFileWriter{
+
+	/*
+	*	Writes features file row by row. Number of rows does not need to be known
+	*	beforehand - header is rewritten with actual number of frames in close().
+	*	File which was not closed (writer destroyed before close()) is deleted.
+	*/
+
+private:
+
+	std::string filepath_;
+	std::ofstream output_;
+	FeaturesFileHeader header_;					// number_of_frames is number of rows written so far
+	std::vector<float> row_buffer_;				// row converted to float32
+
+
+public:
+
+	FeaturesFileWriter(const std::string& filepath, const FeaturesFileHeader& header);
+
+	FeaturesFileWriter(const FeaturesFileWriter&) = delete;
+	FeaturesFileWriter& operator=(const FeaturesFileWriter&) = delete;
+
+	~FeaturesFileWriter();
+
+	// append one row (header.number_of_features values)
+	void write_row(const double* row);
+
+	// append rows which are already float32
+	void write_rows(const float* rows, long long number_of_rows);
+
+	// write final header and close file
+	void close();
+};
+
+
+class FeaturesFile{
+
+	/*
+	*	Read-only memory mapped features (or dataset) file. Rows are used right from
+	*	the mapping, nothing is parsed or copied.
+	*/
+
+private:
+
+	char* mapped_file_;							// whole file
+	size_t mapped_size_;						// file size (bytes)
+	FeaturesFileHeader header_;
+
+
+public:
+
+	FeaturesFile(const std::string& filepath, const char* expected_magic = FEATURES_FILE_MAGIC);
+
+	FeaturesFile(const FeaturesFile&) = delete;
+	FeaturesFile& operator=(const FeaturesFile&) = delete;
+
+	~FeaturesFile();
+
+	const FeaturesFileHeader& get_header() const;
+
+	long long get_number_of_frames() const;
+
+	int get_number_of_features() const;
+
+	// all rows (number_of_frames x number_of_features)
+	const float* get_data() const;
+
+	// labels (dataset files only)
+	const int32_t* get_labels() const;
+
+	// read only header of features file (without mapping whole file)
+	static FeaturesFileHeader read_header(const std::string& filepath, const char* expected_magic = FEATURES_FILE_MAGIC);
+};
@@ -0,0 +1,172 @@
+#include "features_manifest.h"
+
+
+const std::string FeaturesManifest::HEADER = "# VAS features manifest v1";
+
+
+FeaturesManifest::FeaturesManifest(const std::string& manifest_filepath, const std::string& wav_files_folder)
+	: manifest_filepath_(manifest_filepath)
+	, wav_files_folder_(wav_files_folder)
+{ }
+
+std::string FeaturesManifest::get_key(const std::string& wav_filepath) const{
+	if(wav_filepath.compare(0, this->wav_files_folder_.size(), this->wav_files_folder_) == 0){
+		return wav_filepath.substr(this->wav_files_folder_.size());
+	}
+	return wav_filepath;
+}
+
+
+/*
+*	Main interface
+*/
+
+void FeaturesManifest::load(){
+	this->entries_.clear();
+
+	std::ifstream inf(this->manifest_filepath_);
+	if(!inf.is_open()){
+		return;
+	}
+
+	std::string line;
+	if(!std::getline(inf, line) || line != HEADER){
+		std::cout << "FeaturesManifest::load(). Unknown manifest format: " << this->manifest_filepath_ << ". Ignoring it.\n";
+		return;
+	}
+
+	while(std::getline(inf, line)){
+		std::vector<std::string> fields;
+		std::stringstream line_stream(line);
+		std::string field;
+		while(std::getline(line_stream, field, '\t')){
+			fields.push_back(field);
+		}
+
+		if(fields.size() != 5){
+			continue;
+		}
+
+		try{
+			FeaturesManifestEntry entry;
+			entry.file_size = std::stoll(fields[1]);
+			entry.modification_time = std::stoll(fields[2]);
+			entry.content_hash = fields[3];
+			entry.parameters = fields[4];
+			this->entries_[fields[0]] = entry;
+		}
+		catch(std::exception& e){
+			// broken line - file will be extracted anew
+		}
+	}
+}
+
+void FeaturesManifest::save() const{
+	std::string temporary_filepath = this->manifest_filepath_ + ".tmp";
+
+	{
+		std::ofstream outf(temporary_filepath);
+		if(!outf.is_open()){
+			std::cout << "FeaturesManifest::save(). Can't open file " << temporary_filepath << " for writing.\n";
+			throw std::runtime_error("Can't open file " + temporary_filepath);
+		}
+
+		outf << HEADER << '\n';
+		for(const auto& item : this->entries_){
+			const FeaturesManifestEntry& entry = item.second;
+			outf << item.first << '\t' << entry.file_size << '\t' << entry.modification_time << '\t' << entry.content_hash << '\t' << entry.parameters << '\n';
+		}
+	}
+
+	boost::filesystem::rename(temporary_filepath, this->manifest_filepath_);
+}
+
+bool FeaturesManifest::is_up_to_date(const std::string& wav_filepath, const std::string& parameters){
+	auto found = this->entries_.find(this->get_key(wav_filepath));
+	if(found == this->entries_.end()){
+		return false;
+	}
+
+	FeaturesManifestEntry& entry = found->second;
+	if(entry.parameters != parameters){
+		return false;
+	}
+
+	long long file_size = boost::filesystem::file_size(wav_filepath);
+	long long modification_time = boost::filesystem::last_write_time(wav_filepath);
+
+	if(entry.file_size == file_size && entry.modification_time == modification_time){
+		return true;
+	}
+
+	// size or mtime changed - only contents matter
+	if(entry.file_size != file_size || entry.content_hash != hash_file(wav_filepath)){
+		return false;
+	}
+
+	entry.modification_time = modification_time;
+	return true;
+}
+
+void FeaturesManifest::update(const std::string& wav_filepath, const std::string& parameters){
+	FeaturesManifestEntry entry;
+	entry.file_size = boost::filesystem::file_size(wav_filepath);
+	entry.modification_time = boost::filesystem::last_write_time(wav_filepath);
+	entry.content_hash = hash_file(wav_filepath);
+	entry.parameters = parameters;
+
+	this->entries_[this->get_key(wav_filepath)] = entry;
+}
+
+void FeaturesManifest::remove(const std::string& wav_filepath){
+	this->entries_.erase(this->get_key(wav_filepath));
+}
+
+std::vector<std::string> FeaturesManifest::get_files() const{
+	std::vector<std::string> files;
+	for(const auto& item : this->entries_){
+		files.push_back(this->wav_files_folder_ + item.first);
+	}
+	return files;
+}
+
+
+/*
+*	Secondary functions
+*/
+
+std::string FeaturesManifest::hash_file(const std::string& filepath){
+	std::ifstream inf(filepath, std::ios::binary);
+	if(!inf.is_open()){
+		std::cout << "FeaturesManifest::hash_file(...). Can't open file " << filepath << "\n";
+		throw std::runtime_error("Can't open file " + filepath);
+	}
+
+	uint64_t hash = 14695981039346656037ULL;
+	std::vector<char> buffer(1 << 16);
+
+	while(inf){
+		inf.read(buffer.data(), buffer.size());
+		std::streamsize bytes_read = inf.gcount();
+		for(std::streamsize index = 0; index < bytes_read; ++index){
+			hash ^= static_cast<unsigned char>(buffer[index]);
+			hash *= 1099511628211ULL;
+		}
+	}
+
+	std::ostringstream result;
+	result << std::hex << std::setw(16) << std::setfill('0') << hash;
+	return result.str();
+}
+
+std::string FeaturesManifest::get_parameters_signature(const FeaturesParameters& parameters){
+	std::ostringstream result;
+	result << "frame_length=" << parameters.frame_length
+		<< " frame_step=" << parameters.frame_step
+		<< " nb_mfcc=" << parameters.number_of_mfcc_features
+		<< " nb_fbank=" << parameters.number_of_fbank_features
+		<< " normalize=" << parameters.normalize
+		<< " sample_rate=" << parameters.sample_rate
+		<< " format=" << FEATURES_FILE_VERSION;
+	return result.str();
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <boost/filesystem.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "features_engine.h"
+#include "util.cpp"
+
+
+struct FeaturesManifestEntry{
+
+	/*
+	*	State of one wav file at the moment its features were extracted
+	*/
+
+	long long file_size;					// wav file size (bytes)
+	long long modification_time;			// wav file mtime (seconds since epoch)
+	std::string content_hash;				// hash of wav file contents (see FeaturesManifest::hash_file)
+	std::string parameters;					// extraction parameters signature (see FeaturesManifest::get_parameters_signature)
+};
+
+
+class FeaturesManifest{
+
+	/*
+	*	Record of which wav files features folder was extracted from, and how.
+	*	Lets extraction skip files which features are already up to date:
+	*	file is re-extracted only if it is new, its contents changed or it was extracted
+	*	with other parameters.
+	*
+	*	Contents are checked by size and mtime first, file is hashed only if they differ
+	*	(so touching file without changing it does not cause re-extraction).
+	*
+	*	Manifest is a text file, one line per wav file:
+	*		relative_wav_path \t size \t mtime \t hash \t parameters
+	*	Wav paths are stored relative to wav files folder, so data folder can be moved.
+	*/
+
+private:
+
+	static const std::string HEADER;						// first line of manifest file (format version)
+
+	std::string manifest_filepath_;							// where manifest is stored
+	std::string wav_files_folder_;							// folder which wav files paths are relative to
+	std::map<std::string, FeaturesManifestEntry> entries_;	// relative wav path -> entry
+
+	// key of wav file in entries_
+	std::string get_key(const std::string& wav_filepath) const;
+
+
+public:
+
+	FeaturesManifest(const std::string& manifest_filepath, const std::string& wav_files_folder);
+
+	// read manifest from disk (missing or broken manifest is just empty)
+	void load();
+
+	// write manifest to disk (through temporary file, so manifest is never half written)
+	void save() const;
+
+	// features of wav file were extracted with given parameters from current file contents
+	bool is_up_to_date(const std::string& wav_filepath, const std::string& parameters);
+
+	// remember current state of wav file (after its features were extracted)
+	void update(const std::string& wav_filepath, const std::string& parameters);
+
+	// forget wav file
+	void remove(const std::string& wav_filepath);
+
+	// all wav files paths in manifest
+	std::vector<std::string> get_files() const;
+
+	// FNV-1a (64 bit) hash of file contents as hex string
+	static std::string hash_file(const std::string& filepath);
+
+	// string describing everything features depend on
+	static std::string get_parameters_signature(const FeaturesParameters& parameters);
+};
@@ -0,0 +1,184 @@
+#include "fft.h"
+
+
+int next_power_of_two(int value){
+	int result = 1;
+	while(result < value){
+		result <<= 1;
+	}
+	return result;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Real FFT
+//----------------------------------------------------------------------------------------------------
+
+
+RealFFT::RealFFT(int size)
+	: size_(std::max(2, next_power_of_two(size)))
+	, half_size_(size_ / 2)
+{
+#ifdef VAS_USE_FFTW
+	/*
+	*	FFTW_MEASURE overwrites arrays while planning, so planning on temporary arrays.
+	*	FFTW_UNALIGNED - plan is executed on per-thread buffers with any alignment.
+	*/
+
+	double* planning_input = fftw_alloc_real(this->size_);
+	fftw_complex* planning_output = fftw_alloc_complex(this->half_size_ + 1);
+
+	this->plan_ = fftw_plan_dft_r2c_1d(this->size_, planning_input, planning_output, FFTW_MEASURE | FFTW_UNALIGNED);
+
+	fftw_free(planning_input);
+	fftw_free(planning_output);
+#else
+	/*
+	*	Building bit reversal permutation and twiddle factors tables.
+	*	(size is rounded up to the nearest power of two)
+	*/
+
+	int number_of_bits = 0;
+	while((1 << number_of_bits) < this->half_size_){
+		++number_of_bits;
+	}
+
+	this->bit_reversal_.resize(this->half_size_);
+	for(int index = 0; index < this->half_size_; ++index){
+		int reversed = 0;
+		for(int bit = 0; bit < number_of_bits; ++bit){
+			if(index & (1 << bit)){
+				reversed |= 1 << (number_of_bits - 1 - bit);
+			}
+		}
+		this->bit_reversal_[index] = reversed;
+	}
+
+	this->twiddles_.resize(std::max(1, this->half_size_ / 2));
+	for(int k = 0; k < static_cast<int>(this->twiddles_.size()); ++k){
+		this->twiddles_[k] = std::polar(1.0, -2.0 * M_PI * k / this->half_size_);
+	}
+
+	this->split_twiddles_.resize(this->half_size_ + 1);
+	for(int k = 0; k <= this->half_size_; ++k){
+		this->split_twiddles_[k] = std::polar(1.0, -2.0 * M_PI * k / this->size_);
+	}
+#endif
+}
+
+RealFFT::~RealFFT(){
+#ifdef VAS_USE_FFTW
+	fftw_destroy_plan(this->plan_);
+#endif
+}
+
+int RealFFT::get_size() const{
+	return this->size_;
+}
+
+int RealFFT::get_number_of_bins() const{
+	return this->half_size_ + 1;
+}
+
+#ifndef VAS_USE_FFTW
+void RealFFT::complex_transform(std::vector<std::complex<double>>& buffer) const{
+	for(int index = 0; index < this->half_size_; ++index){
+		if(index < this->bit_reversal_[index]){
+			std::swap(buffer[index], buffer[this->bit_reversal_[index]]);
+		}
+	}
+
+	for(int length = 2; length <= this->half_size_; length <<= 1){
+		int half_length = length / 2;
+		int twiddle_step = this->half_size_ / length;
+
+		for(int start = 0; start < this->half_size_; start += length){
+			for(int offset = 0; offset < half_length; ++offset){
+				std::complex<double> u = buffer[start + offset];
+				std::complex<double> v = buffer[start + offset + half_length] * this->twiddles_[offset * twiddle_step];
+				buffer[start + offset] = u + v;
+				buffer[start + offset + half_length] = u - v;
+			}
+		}
+	}
+}
+#endif
+
+void RealFFT::power_spectrum(const double* input, int input_length, double* output, FFTBuffer& buffer) const{
+	/*
+	*	Same semantics as numpy.fft.rfft(frame, N): if frame is longer than N - it is truncated,
+	*	if shorter - zero padded. Result is written into output[0 .. N / 2] as |X[k]|^2 / N
+	*	(python_speech_features.sigproc.powspec)
+	*/
+
+	int used_length = std::min(input_length, this->size_);
+
+#ifdef VAS_USE_FFTW
+	buffer.input.resize(this->size_);
+	buffer.output.resize(this->half_size_ + 1);
+
+	std::copy(input, input + used_length, buffer.input.begin());
+	std::fill(buffer.input.begin() + used_length, buffer.input.end(), 0.0);
+
+	// new-array execute functions are thread-safe
+	fftw_execute_dft_r2c(this->plan_, buffer.input.data(), reinterpret_cast<fftw_complex*>(buffer.output.data()));
+
+	for(int k = 0; k <= this->half_size_; ++k){
+		output[k] = std::norm(buffer.output[k]) / this->size_;
+	}
+#else
+	std::vector<std::complex<double>>& packed = buffer.output;
+	packed.assign(this->half_size_, std::complex<double>(0.0, 0.0));
+
+	for(int index = 0; index < used_length; ++index){
+		if(index & 1){
+			packed[index >> 1].imag(input[index]);
+		}
+		else{
+			packed[index >> 1].real(input[index]);
+		}
+	}
+
+	this->complex_transform(packed);
+
+	for(int k = 0; k <= this->half_size_; ++k){
+		std::complex<double> current = packed[k % this->half_size_];
+		std::complex<double> mirrored = std::conj(packed[(this->half_size_ - k) % this->half_size_]);
+
+		std::complex<double> even = 0.5 * (current + mirrored);
+		std::complex<double> odd = std::complex<double>(0.0, -0.5) * (current - mirrored);
+		std::complex<double> value = even + this->split_twiddles_[k] * odd;
+
+		output[k] = std::norm(value) / this->size_;
+	}
+#endif
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	FFT plans cache
+//----------------------------------------------------------------------------------------------------
+
+
+std::mutex FFTPlanCache::m_plans_lock_;
+std::map<int, std::shared_ptr<const RealFFT>> FFTPlanCache::plans_;
+
+
+std::shared_ptr<const RealFFT> FFTPlanCache::get(int size){
+	int transform_size = std::max(2, next_power_of_two(size));
+
+	std::lock_guard<std::mutex> lock(FFTPlanCache::m_plans_lock_);
+
+	std::shared_ptr<const RealFFT>& plan = FFTPlanCache::plans_[transform_size];
+	if(!plan){
+		plan = std::shared_ptr<const RealFFT>(new RealFFT(transform_size));
+	}
+	return plan;
+}
+
+void FFTPlanCache::clear(){
+	std::lock_guard<std::mutex> lock(FFTPlanCache::m_plans_lock_);
+	FFTPlanCache::plans_.clear();
+}
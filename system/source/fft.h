@@ -0,0 +1,110 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#ifdef VAS_USE_FFTW
+#include <fftw3.h>
+#endif
+
+
+struct FFTBuffer{
+
+	/*
+	*	Per-thread scratch memory for RealFFT::power_spectrum(...).
+	*/
+
+	std::vector<double> input;						// real input, truncated or zero padded to N values
+	std::vector<std::complex<double>> output;		// transform output
+};
+
+
+class RealFFT{
+
+	/*
+	*	Forward FFT for real input signals of power-of-two length.
+	*
+	*	With VAS_USE_FFTW defined (compile with -DVAS_USE_FFTW -lfftw3) transform is done
+	*	by FFTW real-to-complex plan, otherwise by built-in implementation:
+	*	real signal of length N is packed into complex signal of length N/2
+	*	(even samples - real part, odd samples - imaginary part), transformed with
+	*	iterative radix-2 FFT and then split back into N/2 + 1 spectrum bins.
+	*
+	*	All tables (FFTW plan or bit reversal and twiddle factors) are built once in
+	*	constructor, so one RealFFT object can be used for any number of frames. Object
+	*	is not modified while transforming, so it can be shared between threads (each
+	*	thread needs its own buffer).
+	*
+	*	Do not create RealFFT directly - get it from FFTPlanCache (FFTW planner is not thread-safe).
+	*/
+
+private:
+
+	int size_;										// transform length (N, power of two)
+	int half_size_;									// N / 2 (length of packed complex transform)
+
+#ifdef VAS_USE_FFTW
+	fftw_plan plan_;								// r2c plan (executed with new-array interface)
+#else
+	std::vector<int> bit_reversal_;					// bit reversal permutation for N / 2 points
+	std::vector<std::complex<double>> twiddles_;	// exp(-2 * pi * i * k / (N / 2)), k < N / 4
+	std::vector<std::complex<double>> split_twiddles_;	// exp(-2 * pi * i * k / N), k <= N / 2
+
+	// in-place radix-2 transform of N / 2 complex points
+	void complex_transform(std::vector<std::complex<double>>& buffer) const;
+#endif
+
+
+public:
+
+	RealFFT(int size);
+	RealFFT(const RealFFT& another_fft) = delete;
+	RealFFT& operator=(const RealFFT& another_fft) = delete;
+	~RealFFT();
+
+	int get_size() const;
+
+	// number of output bins (N / 2 + 1)
+	int get_number_of_bins() const;
+
+	// power spectrum |X[k]|^2 / N of input (truncated or zero padded to N samples)
+	void power_spectrum(const double* input, int input_length, double* output, FFTBuffer& buffer) const;
+};
+
+
+class FFTPlanCache{
+
+	/*
+	*	Process-wide cache of RealFFT plans keyed by transform length.
+	*
+	*	Frame length is fixed for the whole extraction run, so plan for each length is
+	*	created once (FFTW: with FFTW_MEASURE planning, which is slow to create but gives
+	*	fastest transform) and then shared by all worker threads. After that per-frame FFT
+	*	cost is execution time only.
+	*
+	*	Planning (and plans destruction) is done under one lock, execution is lock-free.
+	*/
+
+private:
+
+	static std::mutex m_plans_lock_;								// guards plans_ and FFTW planner
+	static std::map<int, std::shared_ptr<const RealFFT>> plans_;	// transform length -> plan
+
+
+public:
+
+	// plan for given transform length (created on first request)
+	static std::shared_ptr<const RealFFT> get(int size);
+
+	// destroy all cached plans (plans still used by someone are destroyed by last owner)
+	static void clear();
+};
+
+
+// smallest power of two which is not less than given value
+int next_power_of_two(int value);
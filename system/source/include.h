@@ -1,7 +1,26 @@
 #include "../settings.h"
 #include "kernel.h"
+#include "dataset_builder.h"
+#include "dense_network.h"
 #include "features.h"
+#include "features_engine.h"
+#include "features_file.h"
+#include "features_manifest.h"
+#include "native_model.h"
+#include "random_forest.h"
+#include "sequential_decision.h"
+#include "server.h"
+#include "simd_kernels.h"
 #include "wav_file.h"
 
 #include "kernel.cpp"
+#include "dataset_builder.cpp"
+#include "dense_network.cpp"
 #include "features.cpp"
+#include "features_engine.cpp"
+#include "features_file.cpp"
+#include "features_manifest.cpp"
+#include "native_model.cpp"
+#include "random_forest.cpp"
+#include "sequential_decision.cpp"
+#include "server.cpp"
@@ -13,6 +13,8 @@ AuthenticationKernel::AuthenticationKernel(
 	, int main_voice_class
 	, FEATURES_PREPROCESS preprocess_type
 	, int main_preprocess_voice_class
+	, FEATURES_ENGINE features_engine
+	, const DecisionParameters& decision_parameters
 )
 	: wav_split_frame_length_(wav_split_frame_length)
 	, wav_split_frame_step_(wav_split_frame_step)
@@ -24,14 +26,28 @@ AuthenticationKernel::AuthenticationKernel(
 	, main_voice_class_(main_voice_class)
 	, preprocess_type_(preprocess_type)
 	, main_preprocess_voice_class_(main_preprocess_voice_class_)
+	, features_engine_(features_engine)
+	, decision_parameters_(decision_parameters)
 { }
 
 
+FeaturesParameters AuthenticationKernel::get_features_parameters(){
+	return FeaturesParameters(
+		this->wav_split_frame_length_
+		, this->wav_split_frame_step_
+		, this->number_of_mfcc_features_
+		, this->number_of_fbank_features_
+		, this->normilize_audio_
+		, SETTINGS::SAMPLE_RATE
+	);
+}
+
+
 /*
 *	Main interface
 */
 
-void AuthenticationKernel::extract_features(const std::string& folder_with_wavs, const std::string& folder_to_save_features){
+void AuthenticationKernel::extract_features(const std::string& folder_with_wavs, const std::string& folder_to_save_features, const std::string& manifest_filepath){
 	/*
 	*	Collect all wav files from each folder in specified directory. 
 	*	Each folder with wav file voices should be in following format:	'voice_$_#', where
@@ -43,48 +59,105 @@ void AuthenticationKernel::extract_features(const std::string& folder_with_wavs,
 	*
 	*	Creating same directories structure in 'folder_to_save_features' as in folder with wav files
 	*	('folder_with_wavs'). This done only to manage storage data properly.
+	*
+	*	Extraction is incremental: manifest (see features_manifest.h) remembers wav files features were
+	*	extracted from, so only new, changed or extracted with other parameters files are parsed.
+	*	Features of wav files which are not in 'folder_with_wavs' anymore are deleted.
+	*	(delete manifest file to reparse everything)
 	*	
-	*	See also: features_extractor.h, scripts/py_features.py
+	*	See also: features.h, features_engine.h, features_manifest.h, scripts/features.py
 	*/
 
 	try{
 		// accumulate all files that need to be parsed here
-		PoolFeaturesExtractor features_extractor;
+		PoolFeaturesExtractor features_extractor(std::thread::hardware_concurrency(), this->features_engine_);
+
+		FeaturesParameters parameters = this->get_features_parameters();
+		std::string parameters_signature = FeaturesManifest::get_parameters_signature(parameters);
+
+		FeaturesManifest manifest(manifest_filepath, folder_with_wavs);
+		manifest.load();
+
+		boost::filesystem::create_directories(folder_to_save_features);
 
 		// folders with wav files to parse
 		std::vector<std::string> folders_to_parse = get_directory_entries(folder_with_wavs, false);
 		
-		int total_files_count = 0;
+		std::set<std::string> all_wav_files;			// all wav files found
+		std::set<std::string> all_features_folders;		// features folders of all wav folders found
+		std::set<std::string> all_features_files;		// features files of all wav files found
+		std::vector<std::string> files_to_parse;		// new, changed or stale wav files
 		
 		for(std::string& folder : folders_to_parse){
 			// load filenames from current folder
 			std::vector<std::string> list_of_files = get_directory_entries(folder, true);
 			std::cout << "In folder " << folder << " found " << list_of_files.size() << " files.\n";
 
-			total_files_count += list_of_files.size();
-
 			// get directory name and create same directory in folder with features (folder_to_save_features)
 			std::string output_directory_name(folder.begin() + folder.find_last_of("\\/") + 1, folder.end());
-			if(!boost::filesystem::create_directory(folder_to_save_features + output_directory_name)){
+			boost::filesystem::create_directory(folder_to_save_features + output_directory_name);
+			if(!boost::filesystem::is_directory(folder_to_save_features + output_directory_name)){
 				std::cout << "Can not create directory " + folder_to_save_features + output_directory_name << "\n";
 				throw std::exception();
 			}
+			all_features_folders.insert(folder_to_save_features + output_directory_name);
 
 			for(std::string& filepath : list_of_files){
+				std::string features_filepath = generate_features_output_filepath(filepath);
+
+				all_wav_files.insert(filepath);
+				all_features_files.insert(features_filepath);
+
+				if(boost::filesystem::exists(features_filepath) && manifest.is_up_to_date(filepath, parameters_signature)){
+					continue;
+				}
+
+				// old features should not survive failed extraction
+				manifest.remove(filepath);
+				boost::filesystem::remove(features_filepath);
+
+				files_to_parse.push_back(filepath);
 				features_extractor.add_file(filepath);
 			}
 		}
 
-		std::cout << "Ready to parse " << total_files_count << " files. Running " << features_extractor.get_nb_workers() << " threads." << std::endl;
+		// forget deleted wav files and delete their features (and anything else not extracted from current wav files)
+		for(const std::string& filepath : manifest.get_files()){
+			if(all_wav_files.count(filepath) == 0){
+				manifest.remove(filepath);
+			}
+		}
+
+		for(std::string& folder : get_directory_entries(folder_to_save_features, false)){
+			for(std::string& features_filepath : get_directory_entries(folder, true)){
+				if(all_features_files.count(features_filepath) == 0){
+					boost::filesystem::remove(features_filepath);
+				}
+			}
+			if(all_features_folders.count(folder) == 0 && boost::filesystem::is_empty(folder)){
+				boost::filesystem::remove(folder);
+			}
+		}
+
+		std::cout << "Found " << all_wav_files.size() << " files, " << all_wav_files.size() - files_to_parse.size() << " are up to date.\n";
+		std::cout << "Ready to parse " << files_to_parse.size() << " files. Running " << features_extractor.get_nb_workers() << " threads." << std::endl;
 		
 		// run parsing procedure (pool executer)
-		features_extractor.extract({
-			std::to_string(this->wav_split_frame_length_)
-			, std::to_string(this->wav_split_frame_step_)
-			, std::to_string(this->number_of_fbank_features_)
-			, std::to_string(this->number_of_mfcc_features_)
-			, std::to_string(this->normilize_audio_)
-		});
+		if(!files_to_parse.empty()){
+			features_extractor.extract(parameters);
+		}
+
+		// remember successfully parsed files
+		std::vector<std::string> failed_files = features_extractor.get_failed_files();
+		std::set<std::string> failed_files_set(failed_files.begin(), failed_files.end());
+
+		for(std::string& filepath : files_to_parse){
+			if(failed_files_set.count(filepath) == 0 && boost::filesystem::exists(generate_features_output_filepath(filepath))){
+				manifest.update(filepath, parameters_signature);
+			}
+		}
+
+		manifest.save();
 	}
 	catch(std::exception& e){
 		std::cout << "void AuthenticationKernel::extract_features(...). Exception while parsing wav files.\n";
@@ -96,6 +169,8 @@ void AuthenticationKernel::create_train_test(const std::string& folder_to_save){
 	/*
 	*	Creating train and test samples with wav file features (extracted before, no checks).
 	*	Path from where to load all wav files features specified in SETTINGS.
+	*	Sample is one dataset file (see features_file.h): all features rows one after another
+	*	and then class of each row. Files are copied in parallel (see dataset_builder.h).
 	*	
 	*	Here we can manage creation of train and test samples using multiclass classification
 	*	or one-vs-all classification. In one-vs-all classification using this->main_voice_class_
@@ -125,49 +200,10 @@ void AuthenticationKernel::create_train_test(const std::string& folder_to_save){
 
 			std::cout << "Creating " << routine_name << " for model with description: " << folder_to_save << "\n";	
 
-			// delete old file and create anew
-			std::fstream outf(output_filepath, std::fstream::out);
-
-			// add header in result file
-			outf << "Class,Features\n";
-
-			// data in train or test will be collected from all files with *.features signature
-			// those files are stored separately in folders for each voice
-			for(std::string& folder : get_directory_entries(data_folderpath, false)){
-				// get voice class (id) from folder name (here is no need it to be int)
-				int current_voice_class = std::stoi(std::string(folder.begin() + folder.find_last_of("_") + 1, folder.end()));
-
-				// remake class id if one-vs-all specified
-				if(this->one_vs_all_){
-					if(current_voice_class == this->main_voice_class_){
-						current_voice_class = 1;
-					}
-					else{
-						current_voice_class = 0;
-					}
-				}
-
-				// copy all data from *.features files to train (or test) sample
-				for(std::string& current_filepath : get_directory_entries(folder, true)){
-					// combine only files with features
-					if(std::string(current_filepath.begin() + current_filepath.find_last_of("."), current_filepath.end()) != SETTINGS::FEATURES_FILES_EXTENSION){
-						continue;
-					}
-
-					// read current file
-					std::fstream inf(current_filepath, std::fstream::in);
-
-					// line by line
-					std::string line_buffer;
-					while(std::getline(inf, line_buffer)){
-						outf << current_voice_class << "," << line_buffer << "\n";
-					}
-
-					inf.close();
-				}
-			}
-
-			outf.close();
+			// all files from features folder, classes are remapped in one-vs-all mode
+			DatasetBuilder dataset_builder(this->one_vs_all_, this->main_voice_class_);
+			dataset_builder.add_features_folder(data_folderpath);
+			dataset_builder.build(output_filepath, this->number_of_mfcc_features_ + this->number_of_fbank_features_);
 		}
 	}
 	catch(std::exception& e){
@@ -215,7 +251,8 @@ int AuthenticationKernel::predict(const std::string& model_folder){
 	*	specified in SETTINGS folder. 
 	*
 	*	Extracting features and running python script, which will load specified model dump
-	*	(our system can manage many models (classificators)).
+	*	(our system can manage many models (classificators)). If model was exported in native
+	*	format, it is run in-process instead (no python at all).
 	*	
 	*	Parameters for python script:
 	*	 - mode (fit or predict. Here - predict)
@@ -229,19 +266,18 @@ int AuthenticationKernel::predict(const std::string& model_folder){
 	*/
 
 	try{
+		// native model extracts features itself (while reading test file)
+		if(this->features_engine_ == FEATURES_ENGINE::NATIVE && this->predict_native(model_folder)){
+			return 0;
+		}
+
 		// extract and save features from test file
 		// (as long as we have 1 file - we only need max 1 thread)
-		PoolFeaturesExtractor features_extractor(1);
+		PoolFeaturesExtractor features_extractor(1, this->features_engine_);
 		features_extractor.add_file(SETTINGS::TEST_WAV_FILE_SAVE_PATH);
 
 		std::cout << "Ready to extract features from test file.\n";
-		features_extractor.extract({
-			std::to_string(this->wav_split_frame_length_)
-			, std::to_string(this->wav_split_frame_step_)
-			, std::to_string(this->number_of_fbank_features_)
-			, std::to_string(this->number_of_mfcc_features_)
-			, std::to_string(this->normilize_audio_)
-		});
+		features_extractor.extract(this->get_features_parameters());
 
 		// running python script and saving prediction results
 		std::string command = "python " + SETTINGS::PYTHON_MODEL_TRAINING_SCRIPT_PATH + " predict";
@@ -257,3 +293,144 @@ int AuthenticationKernel::predict(const std::string& model_folder){
 		std::cout << e.what() << '\n';
 	}
 }
+
+
+bool AuthenticationKernel::predict_native(const std::string& model_folder){
+	/*
+	*	Test file is read frame by frame, frames are extracted and scored in small blocks.
+	*	With early decision rule (see sequential_decision.h) reading stops as soon as
+	*	class is decided, so usually only beginning of recording is processed.
+	*/
+
+	std::string native_model_filepath = model_folder + SETTINGS::NATIVE_MODEL_OUTPUT_NAME;
+	if(!boost::filesystem::exists(native_model_filepath)){
+		return false;
+	}
+
+	try{
+		std::unique_ptr<NativeModel> model = NativeModel::load(native_model_filepath);
+		model->set_number_of_threads(std::thread::hardware_concurrency());
+
+		FeaturesEngine engine(this->get_features_parameters());
+		WavFrameReader frames_reader(SETTINGS::TEST_WAV_FILE_SAVE_PATH, this->wav_split_frame_length_, this->wav_split_frame_step_);
+		if(!check_wav_file_format(frames_reader.get_header())){
+			throw std::runtime_error("Unsupported wav file format: " + SETTINGS::TEST_WAV_FILE_SAVE_PATH);
+		}
+
+		SequentialDecision decision(model->get_number_of_classes(), this->decision_parameters_);
+		decision.decide([&](FrameSamples& frame){ return frames_reader.next_frame(frame); }, engine, *model);
+
+		std::cout << "Test file class is decided by " << decision.get_number_of_frames() << " of " << frames_reader.get_number_of_frames() << " frames.\n";
+
+		std::ofstream outf(SETTINGS::TEST_WAV_PREDICTION_PATH);
+		outf << decision.get_class();
+	}
+	catch(std::exception& e){
+		std::cout << "bool AuthenticationKernel::predict_native(). Native model can't be used, running python script.\n";
+		std::cout << e.what() << '\n';
+		return false;
+	}
+
+	return true;
+}
+
+
+void AuthenticationKernel::predict_stream(int file_descriptor, const std::string& model_folder){
+	/*
+	*	Voice is streamed (e.g. wav_record.py stream), not saved in file first. With native model
+	*	frames are extracted and scored while recording goes on, and it is stopped as soon as class
+	*	is decided (see sequential_decision.h). Otherwise recording is saved as test file when
+	*	stream ends and predict(...) is run on it.
+	*/
+
+	std::vector<short> recording;
+	PcmStreamFrameReader frames_reader(
+		file_descriptor
+		, this->wav_split_frame_length_
+		, this->wav_split_frame_step_
+		, static_cast<long long>(SETTINGS::SAMPLE_RATE) * SETTINGS::MAX_STREAM_SECONDS
+		, ""
+		, &recording
+	);
+
+	std::string native_model_filepath = model_folder + SETTINGS::NATIVE_MODEL_OUTPUT_NAME;
+	if(this->features_engine_ == FEATURES_ENGINE::NATIVE && boost::filesystem::exists(native_model_filepath)){
+		try{
+			std::unique_ptr<NativeModel> model = NativeModel::load(native_model_filepath);
+			model->set_number_of_threads(std::thread::hardware_concurrency());
+
+			FeaturesEngine engine(this->get_features_parameters());
+			SequentialDecision decision(model->get_number_of_classes(), this->decision_parameters_);
+			decision.decide([&](FrameSamples& frame){ return frames_reader.next_frame(frame); }, engine, *model);
+
+			std::cout << "Streamed voice class is decided by " << decision.get_number_of_frames() << " frames ("
+				<< frames_reader.get_number_of_samples() << " samples received).\n";
+
+			std::ofstream outf(SETTINGS::TEST_WAV_PREDICTION_PATH);
+			outf << decision.get_class();
+			return;
+		}
+		catch(std::exception& e){
+			std::cout << "void AuthenticationKernel::predict_stream(). Native model can't be used, running python script.\n";
+			std::cout << e.what() << '\n';
+		}
+	}
+
+	try{
+		// python script needs whole recording
+		FrameSamples frame;
+		while(frames_reader.next_frame(frame));
+
+		WavFile::save_samples(SETTINGS::TEST_WAV_FILE_SAVE_PATH, recording.data(), recording.size(), SETTINGS::SAMPLE_RATE);
+	}
+	catch(std::exception& e){
+		std::cout << "void AuthenticationKernel::predict_stream(). Exception while saving streamed voice.\n";
+		std::cout << e.what() << '\n';
+		return;
+	}
+
+	this->predict(model_folder);
+}
+
+
+bool AuthenticationKernel::predict_with_server(const std::string& model_folder){
+	/*
+	*	Same as predict(...), but features are extracted and model is run by authentication
+	*	server (see server.h), which has everything loaded already. Result is saved in the same file.
+	*/
+
+	if(!AuthenticationServer::is_running(SETTINGS::SERVER_SOCKET_PATH)){
+		return false;
+	}
+
+	try{
+		std::cout << "Sending test file to authentication server.\n";
+		std::string answer = AuthenticationServer::send_request(SETTINGS::SERVER_SOCKET_PATH, "predict " + SETTINGS::TEST_WAV_FILE_SAVE_PATH + " " + model_folder);
+
+		if(answer.compare(0, 3, "ok ") != 0){
+			std::cout << "Authentication server: " << answer << "\n";
+			return true;
+		}
+
+		std::ofstream outf(SETTINGS::TEST_WAV_PREDICTION_PATH);
+		outf << answer.substr(3);
+	}
+	catch(std::exception& e){
+		std::cout << "bool AuthenticationKernel::predict_with_server(). Exception while predicting current recorded voice class.\n";
+		std::cout << e.what() << '\n';
+	}
+
+	return true;
+}
+
+
+void AuthenticationKernel::serve(const std::string& model_folder){
+	try{
+		AuthenticationServer server(SETTINGS::SERVER_SOCKET_PATH, this->get_features_parameters(), model_folder, this->model_name_, this->decision_parameters_);
+		server.run();
+	}
+	catch(std::exception& e){
+		std::cout << "void AuthenticationKernel::serve(). Exception while running authentication server.\n";
+		std::cout << e.what() << '\n';
+	}
+}
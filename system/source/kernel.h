@@ -4,12 +4,20 @@
 #include <boost/filesystem.hpp>
 #include <iostream>
 #include <fstream>
+#include <memory>
+#include <set>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "../settings.h"
+#include "dataset_builder.h"
 #include "features.h"
+#include "features_manifest.h"
+#include "native_model.h"
+#include "sequential_decision.h"
+#include "server.h"
 #include "util.cpp"
 
 
@@ -24,8 +32,8 @@ class AuthenticationKernel{
 	*	All wav files will be splitted into smaller frames. All features are generated
 	*	over these frames (frames are not being saved anywhere, they are proceeded online)
 	*
-	*	All routine is done with the help of python scripts. So, basically, this is just
-	*	C++ wrapper for voice classificator.
+	*	Features are extracted in-process (see features_engine.h), models are trained
+	*	with the help of python scripts and run in-process if they can be (see native_model.h).
 	*/
 
 
@@ -44,6 +52,17 @@ private:
 	FEATURES_PREPROCESS preprocess_type_;	// preprocess features with this function (see more in settings.h)
 	int main_preprocess_voice_class_;		// main voice class in features preprocess routine (may be None)
 
+	FEATURES_ENGINE features_engine_;		// extract features in-process or with reference python script
+	DecisionParameters decision_parameters_;	// when class of test file is decided (see sequential_decision.h)
+
+
+	// features extraction parameters of current kernel
+	FeaturesParameters get_features_parameters();
+
+	// classify test file with native model (see native_model.h), frames are extracted and scored
+	// while file is read. False if there is no usable native model
+	bool predict_native(const std::string& model_folder);
+
 
 public:
 
@@ -58,10 +77,12 @@ public:
 		, int main_voice_class_ = -1
 		, FEATURES_PREPROCESS preprocess_type = FEATURES_PREPROCESS::NO_PREPROCESS
 		, int main_preprocess_voice_class = -1
+		, FEATURES_ENGINE features_engine = FEATURES_ENGINE::NATIVE
+		, const DecisionParameters& decision_parameters = DecisionParameters()
 	);
 
-	// extract features from all wav files (from folders specified in SETTINGS::)
-	void extract_features(const std::string& folder_with_wavs, const std::string& folder_to_save);
+	// extract features from new or changed wav files (from folders specified in SETTINGS::), see manifest in features_manifest.h
+	void extract_features(const std::string& folder_with_wavs, const std::string& folder_to_save, const std::string& manifest_filepath);
 
 	// create train test files for current model
 	void create_train_test(const std::string& folder_to_save);
@@ -69,6 +90,16 @@ public:
 	// train model and save dump (python script)
 	int fit(const std::string& model_folder);
 	
-	// test recorded voice (python script)
+	// test recorded voice (native model if it was exported, python script otherwise)
 	int predict(const std::string& model_folder);
+
+	// test voice which is being recorded: raw PCM16 samples (see wav_file.h::PcmStreamFrameReader) are read
+	// from given descriptor (pipe or socket) and scored while they arrive
+	void predict_stream(int file_descriptor, const std::string& model_folder);
+
+	// test recorded voice with running authentication server (see server.h). False if server is not running
+	bool predict_with_server(const std::string& model_folder);
+
+	// run authentication server (until it gets "shutdown" request), model from given folder is default one
+	void serve(const std::string& model_folder);
 };
@@ -0,0 +1,176 @@
+#include "native_model.h"
+#include "dense_network.h"
+#include "random_forest.h"
+
+
+const char NATIVE_MODEL_MAGIC[4] = {'V', 'A', 'S', 'M'};
+const uint32_t NATIVE_MODEL_VERSION = 1;
+
+const double NativeModel::CHECK_TOLERANCE = 1e-4;
+
+
+NativeModel::NativeModel(const NativeModelHeader& header, std::istream& input)
+	: header_(header)
+{
+	if(header.preprocess_statistics_dimension != 0 && header.preprocess_statistics_dimension != header.input_dimension){
+		throw std::runtime_error("Native model preprocess statistics do not match model input");
+	}
+
+	this->preprocess_means_.resize(header.preprocess_statistics_dimension);
+	this->preprocess_stds_.resize(header.preprocess_statistics_dimension);
+	read_values(input, this->preprocess_means_.data(), this->preprocess_means_.size());
+	read_values(input, this->preprocess_stds_.data(), this->preprocess_stds_.size());
+
+	this->check_inputs_.resize(static_cast<size_t>(header.number_of_check_rows) * header.input_dimension);
+	this->check_outputs_.resize(static_cast<size_t>(header.number_of_check_rows) * header.number_of_classes);
+	read_values(input, this->check_inputs_.data(), this->check_inputs_.size());
+	read_values(input, this->check_outputs_.data(), this->check_outputs_.size());
+}
+
+NativeModel::~NativeModel()
+{ }
+
+void NativeModel::preprocess(float* rows, long long number_of_rows) const{
+	/*
+	*	Same as scripts/utilities.py::FeaturesPreprocess in test mode
+	*/
+
+	if(this->header_.preprocess_type != static_cast<uint32_t>(FEATURES_PREPROCESS::NORMALIZATION) || number_of_rows == 0){
+		return;
+	}
+
+	int dimension = this->header_.input_dimension;
+	std::vector<float> means(this->preprocess_means_), stds(this->preprocess_stds_);
+
+	// no main voice class in train - rows are normalized with their own statistics
+	if(means.empty()){
+		std::vector<double> sums(dimension, 0.0), squares_sums(dimension, 0.0);
+		for(long long row = 0; row < number_of_rows; ++row){
+			for(int column = 0; column < dimension; ++column){
+				double value = rows[row * dimension + column];
+				sums[column] += value;
+				squares_sums[column] += value * value;
+			}
+		}
+
+		means.resize(dimension);
+		stds.resize(dimension);
+		for(int column = 0; column < dimension; ++column){
+			double mean = sums[column] / number_of_rows;
+			means[column] = mean;
+			stds[column] = std::sqrt(std::max(0.0, squares_sums[column] / number_of_rows - mean * mean));
+		}
+	}
+
+	for(long long row = 0; row < number_of_rows; ++row){
+		for(int column = 0; column < dimension; ++column){
+			float& value = rows[row * dimension + column];
+			value = (value - means[column]) / stds[column];
+		}
+	}
+}
+
+void NativeModel::verify() const{
+	std::vector<float> outputs(this->check_outputs_.size());
+	this->predict_proba(this->check_inputs_.data(), this->header_.number_of_check_rows, outputs.data());
+
+	for(size_t index = 0; index < outputs.size(); ++index){
+		if(!(std::fabs(outputs[index] - this->check_outputs_[index]) <= CHECK_TOLERANCE)){
+			throw std::runtime_error(
+				"Native model output differs from python model output (" + std::to_string(outputs[index])
+				+ " instead of " + std::to_string(this->check_outputs_[index]) + ")"
+			);
+		}
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+int NativeModel::get_input_dimension() const{
+	return this->header_.input_dimension;
+}
+
+int NativeModel::get_number_of_classes() const{
+	return this->header_.number_of_classes;
+}
+
+void NativeModel::set_number_of_threads(int)
+{ }
+
+bool NativeModel::is_streamable() const{
+	return this->header_.preprocess_type != static_cast<uint32_t>(FEATURES_PREPROCESS::NORMALIZATION) || !this->preprocess_means_.empty();
+}
+
+void NativeModel::score_frames_proba(const float* rows, long long number_of_rows, float* output) const{
+	std::vector<float> preprocessed(rows, rows + number_of_rows * this->header_.input_dimension);
+	this->preprocess(preprocessed.data(), number_of_rows);
+	this->predict_proba(preprocessed.data(), number_of_rows, output);
+}
+
+std::vector<int> NativeModel::score_frames(const float* rows, long long number_of_rows) const{
+	int number_of_classes = this->header_.number_of_classes;
+
+	std::vector<float> probabilities(number_of_rows * number_of_classes);
+	this->score_frames_proba(rows, number_of_rows, probabilities.data());
+
+	std::vector<int> frames_classes(number_of_rows);
+	for(long long row = 0; row < number_of_rows; ++row){
+		const float* row_probabilities = probabilities.data() + row * number_of_classes;
+		frames_classes[row] = std::max_element(row_probabilities, row_probabilities + number_of_classes) - row_probabilities + 1;
+	}
+
+	return frames_classes;
+}
+
+int NativeModel::classify(const float* rows, long long number_of_rows) const{
+	/*
+	*	Same as scripts/run_auth.py::classify_wav_features
+	*/
+
+	if(number_of_rows == 0){
+		throw std::runtime_error("No frames to classify");
+	}
+
+	return vote(this->score_frames(rows, number_of_rows), this->header_.number_of_classes);
+}
+
+int NativeModel::vote(const std::vector<int>& frames_classes, int number_of_classes){
+	std::vector<long long> votes(number_of_classes + 1, 0);
+	for(int frame_class : frames_classes){
+		++votes[frame_class];
+	}
+
+	return std::max_element(votes.begin() + 1, votes.end()) - votes.begin();
+}
+
+std::unique_ptr<NativeModel> NativeModel::load(const std::string& filepath){
+	std::ifstream input(filepath, std::ios::binary);
+	if(!input.is_open()){
+		std::cout << "NativeModel::load(...). Can't open file " << filepath << "\n";
+		throw std::runtime_error("Can't open file " + filepath);
+	}
+
+	NativeModelHeader header;
+	read_values(input, &header, 1);
+	if(std::memcmp(header.magic, NATIVE_MODEL_MAGIC, sizeof(header.magic)) != 0 || header.version != NATIVE_MODEL_VERSION){
+		std::cout << "NativeModel::load(...). Invalid native model file: " << filepath << "\n";
+		throw std::runtime_error("Invalid native model file: " + filepath);
+	}
+
+	std::unique_ptr<NativeModel> model;
+	if(header.model_type == static_cast<uint32_t>(NATIVE_MODEL_TYPE::DENSE_NETWORK)){
+		model.reset(new DenseNetwork(header, input));
+	}
+	else if(header.model_type == static_cast<uint32_t>(NATIVE_MODEL_TYPE::RANDOM_FOREST)){
+		model.reset(new RandomForest(header, input));
+	}
+	else{
+		throw std::runtime_error("Unknown native model type " + std::to_string(header.model_type));
+	}
+
+	model->verify();
+	return model;
+}
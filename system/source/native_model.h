@@ -0,0 +1,131 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../settings.h"
+
+
+enum class NATIVE_MODEL_TYPE : int {
+	DENSE_NETWORK, RANDOM_FOREST		// scripts/models.py::NeuralNetModel or RandomForestModel
+};
+
+
+struct NativeModelHeader{
+
+	/*
+	*	Header of native model file (written by scripts/models.py next to model dump,
+	*	see SETTINGS::NATIVE_MODEL_OUTPUT_NAME). Whole file is (little endian):
+	*	 - this header (32 bytes)
+	*	 - features preprocess: preprocess_statistics_dimension float32 means, then as many float32 stds
+	*	 - check rows: number_of_check_rows x input_dimension float32 model inputs (already preprocessed),
+	*	   then number_of_check_rows x number_of_classes float32 outputs of python model on them
+	*	 - model itself (see model classes, e.g. dense_network.h)
+	*/
+
+	char magic[4];									// NATIVE_MODEL_MAGIC
+	uint32_t version;								// NATIVE_MODEL_VERSION
+	uint32_t model_type;							// NATIVE_MODEL_TYPE
+	uint32_t input_dimension;						// number of features in one row
+	uint32_t number_of_classes;						// number of model outputs
+	uint32_t preprocess_type;						// FEATURES_PREPROCESS
+	uint32_t preprocess_statistics_dimension;		// 0 if normalization uses statistics of classified rows themselves
+	uint32_t number_of_check_rows;
+};
+
+static_assert(sizeof(NativeModelHeader) == 32, "NativeModelHeader layout is shared with python scripts");
+
+
+extern const char NATIVE_MODEL_MAGIC[4];
+extern const uint32_t NATIVE_MODEL_VERSION;
+
+
+class NativeModel{
+
+	/*
+	*	Trained model evaluated in-process, without python and its libraries.
+	*	Features are preprocessed the same way python scripts do it
+	*	(see scripts/run_auth.py::classify_wav_features).
+	*
+	*	Right after loading, model is run on check rows and its outputs are compared
+	*	with outputs of python model, so mismatch of exporter and evaluator can't be
+	*	used silently.
+	*/
+
+protected:
+
+	static const double CHECK_TOLERANCE;			// max difference with python model outputs
+
+	NativeModelHeader header_;
+	std::vector<float> preprocess_means_;			// normalization statistics (empty if not stored)
+	std::vector<float> preprocess_stds_;
+	std::vector<float> check_inputs_;				// check rows (see NativeModelHeader)
+	std::vector<float> check_outputs_;
+
+	// read header sections (preprocess, check rows), model reads the rest of file
+	NativeModel(const NativeModelHeader& header, std::istream& input);
+
+	// read 'size' values of type T from model file
+	template<typename T>
+	static void read_values(std::istream& input, T* values, size_t size);
+
+	// features preprocess (in place)
+	void preprocess(float* rows, long long number_of_rows) const;
+
+	// compare outputs on check rows with outputs of python model. Throws on mismatch
+	void verify() const;
+
+
+public:
+
+	NativeModel(const NativeModel&) = delete;
+	NativeModel& operator=(const NativeModel&) = delete;
+
+	virtual ~NativeModel();
+
+	int get_input_dimension() const;
+
+	int get_number_of_classes() const;
+
+	// max number of threads to score rows with (ignored by models which score rows in one thread)
+	virtual void set_number_of_threads(int number_of_threads);
+
+	// probabilities of each class for each (already preprocessed) row, output is number_of_rows x number_of_classes
+	virtual void predict_proba(const float* rows, long long number_of_rows, float* output) const = 0;
+
+	// frames can be scored before all frames of wav file are known
+	// (preprocess does not need statistics of whole wav file)
+	bool is_streamable() const;
+
+	// probabilities of classes for each frame (frames are preprocessed first), output is number_of_rows x number_of_classes
+	void score_frames_proba(const float* rows, long long number_of_rows, float* output) const;
+
+	// class of each frame of wav file (class with max probability, classes start with 1).
+	// All frames are preprocessed and scored at once, as one matrix
+	std::vector<int> score_frames(const float* rows, long long number_of_rows) const;
+
+	// class of wav file by features of its frames (most common class of frames)
+	int classify(const float* rows, long long number_of_rows) const;
+
+	// most common class (smaller class on tie), as Counter::most_common in scripts/run_auth.py
+	static int vote(const std::vector<int>& frames_classes, int number_of_classes);
+
+	// load and verify native model file. Throws if file is invalid
+	static std::unique_ptr<NativeModel> load(const std::string& filepath);
+};
+
+
+template<typename T>
+void NativeModel::read_values(std::istream& input, T* values, size_t size){
+	if(!input.read(reinterpret_cast<char*>(values), sizeof(T) * size)){
+		throw std::runtime_error("Native model file is truncated");
+	}
+}
@@ -0,0 +1,114 @@
+#include "random_forest.h"
+
+
+const int RandomForest::ROWS_BLOCK = 64;
+const int RandomForest::MIN_ROWS_PER_THREAD = 128;
+
+
+RandomForest::RandomForest(const NativeModelHeader& header, std::istream& input)
+	: NativeModel(header, input)
+	, number_of_threads_(1)
+{
+	uint32_t sizes[3];
+	read_values(input, sizes, 3);
+
+	uint32_t number_of_trees = sizes[0], number_of_nodes = sizes[1], number_of_leaves = sizes[2];
+
+	this->roots_.resize(number_of_trees);
+	this->features_.resize(number_of_nodes);
+	this->thresholds_.resize(number_of_nodes);
+	this->left_children_.resize(number_of_nodes);
+	this->right_children_.resize(number_of_nodes);
+	this->leaves_.resize(static_cast<size_t>(number_of_leaves) * header.number_of_classes);
+
+	read_values(input, this->roots_.data(), this->roots_.size());
+	read_values(input, this->features_.data(), this->features_.size());
+	read_values(input, this->thresholds_.data(), this->thresholds_.size());
+	read_values(input, this->left_children_.data(), this->left_children_.size());
+	read_values(input, this->right_children_.data(), this->right_children_.size());
+	read_values(input, this->leaves_.data(), this->leaves_.size());
+
+	// traversal does not check bounds, so whole forest is checked once here
+	if(number_of_trees == 0){
+		throw std::runtime_error("Random forest has no trees");
+	}
+	for(int32_t root : this->roots_){
+		if(root < 0 || static_cast<uint32_t>(root) >= number_of_nodes){
+			throw std::runtime_error("Invalid random forest root node");
+		}
+	}
+	for(uint32_t node = 0; node < number_of_nodes; ++node){
+		bool is_leaf = this->features_[node] < 0;
+		uint32_t children_limit = is_leaf ? number_of_leaves : number_of_nodes;
+		bool valid = this->left_children_[node] >= 0 && static_cast<uint32_t>(this->left_children_[node]) < children_limit
+			&& this->right_children_[node] >= 0 && static_cast<uint32_t>(this->right_children_[node]) < children_limit
+			&& (is_leaf || static_cast<uint32_t>(this->features_[node]) < header.input_dimension);
+
+		// children always go after parent (sklearn builds trees depth first), so there are no cycles
+		if(!valid || (!is_leaf && (static_cast<uint32_t>(this->left_children_[node]) <= node || static_cast<uint32_t>(this->right_children_[node]) <= node))){
+			throw std::runtime_error("Invalid random forest node " + std::to_string(node));
+		}
+	}
+}
+
+void RandomForest::predict_block(const float* rows, long long first_row, long long last_row, float* output) const{
+	int dimension = this->header_.input_dimension;
+	int number_of_classes = this->header_.number_of_classes;
+
+	std::fill(output + first_row * number_of_classes, output + last_row * number_of_classes, 0.0f);
+
+	for(int32_t root : this->roots_){
+		for(long long row = first_row; row < last_row; ++row){
+			const float* values = rows + row * dimension;
+
+			int32_t node = root;
+			while(this->features_[node] >= 0){
+				node = values[this->features_[node]] <= this->thresholds_[node] ? this->left_children_[node] : this->right_children_[node];
+			}
+
+			const float* leaf = this->leaves_.data() + static_cast<size_t>(this->left_children_[node]) * number_of_classes;
+			float* row_output = output + row * number_of_classes;
+			for(int index = 0; index < number_of_classes; ++index){
+				row_output[index] += leaf[index];
+			}
+		}
+	}
+
+	float scale = 1.0f / this->roots_.size();
+	for(long long index = first_row * number_of_classes; index < last_row * number_of_classes; ++index){
+		output[index] *= scale;
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+void RandomForest::set_number_of_threads(int number_of_threads){
+	this->number_of_threads_ = std::max(1, number_of_threads);
+}
+
+void RandomForest::predict_proba(const float* rows, long long number_of_rows, float* output) const{
+	long long number_of_threads = std::min<long long>(this->number_of_threads_, number_of_rows / MIN_ROWS_PER_THREAD);
+
+	auto thread_worker = [&](long long thread_index){
+		// each thread scores every number_of_threads-th block
+		for(long long first_row = thread_index * ROWS_BLOCK; first_row < number_of_rows; first_row += ROWS_BLOCK * std::max(1LL, number_of_threads)){
+			this->predict_block(rows, first_row, std::min<long long>(first_row + ROWS_BLOCK, number_of_rows), output);
+		}
+	};
+
+	if(number_of_threads <= 1){
+		thread_worker(0);
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	for(long long thread_index = 0; thread_index < number_of_threads; ++thread_index){
+		workers.emplace_back(thread_worker, thread_index);
+	}
+	for(auto& worker : workers){
+		worker.join();
+	}
+}
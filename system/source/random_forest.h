@@ -0,0 +1,61 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "native_model.h"
+
+
+class RandomForest : public NativeModel{
+
+	/*
+	*	Random forest (see scripts/models.py::RandomForestModel), evaluated the way sklearn does it:
+	*	row goes to left child if row[feature] <= threshold, probabilities of classes are mean
+	*	of probabilities in leaves row reaches in all trees.
+	*
+	*	Nodes of all trees are stored in flat arrays (struct of arrays) instead of node objects,
+	*	so traversal reads small contiguous arrays. Rows are scored in blocks: each tree is applied
+	*	to all rows of block before next tree, so nodes of tree stay in cache. Blocks of rows
+	*	are scored by several threads if many rows are scored at once.
+	*
+	*	Model part of native model file:
+	*	 - uint32 number_of_trees, number_of_nodes, number_of_leaves
+	*	 - number_of_trees int32 root nodes
+	*	 - number_of_nodes int32 features (-1 for leaf), float32 thresholds, int32 left children, int32 right children
+	*	   (children of leaf - index of its probabilities)
+	*	 - number_of_leaves x number_of_classes float32 leaves probabilities
+	*/
+
+private:
+
+	static const int ROWS_BLOCK;					// rows scored by all trees at once
+	static const int MIN_ROWS_PER_THREAD;			// less rows are not worth one more thread
+
+	std::vector<int32_t> roots_;					// root node of each tree
+	std::vector<int32_t> features_;					// nodes
+	std::vector<float> thresholds_;
+	std::vector<int32_t> left_children_;
+	std::vector<int32_t> right_children_;
+	std::vector<float> leaves_;						// probabilities of classes in each leaf
+
+	int number_of_threads_;
+
+	// probabilities for rows [first_row, last_row)
+	void predict_block(const float* rows, long long first_row, long long last_row, float* output) const;
+
+
+public:
+
+	// read model part of native model file (header sections are read by NativeModel)
+	RandomForest(const NativeModelHeader& header, std::istream& input);
+
+	// max number of threads to score rows with (1 by default)
+	void set_number_of_threads(int number_of_threads) override;
+
+	void predict_proba(const float* rows, long long number_of_rows, float* output) const override;
+};
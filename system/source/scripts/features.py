@@ -1,12 +1,12 @@
 import sys
 import numpy as np
 from python_speech_features import mfcc, logfbank
-from utilities import get_wav_amplitudes
+from utilities import get_wav_amplitudes, load_features_file, save_features_file
 
 
 def extract_features(
     path_to_wav_file            # absolute path to wav file to extract features from
-    , path_to_store_results     # absolute path to text file to store extracted results to
+    , path_to_store_results     # absolute path to binary features file to store extracted results to
     , frame_length              # size of frame of wav file to extract features for [seconds]
     , frame_step                # shift frame window on that amount of time [seconds]
     , nb_fbank_features         # number of filterbank features to extract
@@ -46,12 +46,37 @@ def extract_features(
     # combine and save in file
     assert(len(mfcc_frames_features) == len(fbank_frames_features))
 
-    with open(path_to_store_results, 'w') as outf:
-        for frame_features in np.concatenate((mfcc_frames_features, fbank_frames_features), axis=1):
-            outf.write(' '.join(map(str, frame_features)))
-            outf.write('\n')
+    save_features_file(
+        path_to_store_results
+        , np.concatenate((mfcc_frames_features, fbank_frames_features), axis=1)
+        , frame_length, frame_step, nb_mfcc_features, nb_fbank_features, sample_rate, normilize
+    )
+
+
+def compare_features(path_to_first_features, path_to_second_features, tolerance=1e-6):
+    """
+    Compare two features files frame by frame. Used to check native (C++) features
+    engine output against this script output for the same wav file.
+
+    :return True if all values are equal up to relative tolerance
+    """
+    first = load_features_file(path_to_first_features)[1]
+    second = load_features_file(path_to_second_features)[1]
+
+    if first.shape != second.shape:
+        print 'Features shapes differ: {} vs {}'.format(first.shape, second.shape)
+        return False
+
+    abs_diff = np.abs(first - second)
+    rel_diff = abs_diff / np.maximum(np.abs(second), 1e-12)
+    print 'Frames: {}, max abs diff: {}, max rel diff: {}'.format(len(first), abs_diff.max(), rel_diff.max())
+    return bool(np.all(np.isclose(first, second, rtol=float(tolerance), atol=float(tolerance))))
 
 
 if __name__ == '__main__':
-    extract_features(*sys.argv[1:])
+    if sys.argv[1] == 'compare':
+        equal = compare_features(*sys.argv[2:])
+        sys.exit(0 if equal else 1)
+    else:
+        extract_features(*sys.argv[1:])
     
\ No newline at end of file
@@ -1,6 +1,8 @@
 import keras
+import os
 import sys
 import json
+import struct
 import pandas
 import numpy as np
 import cPickle
@@ -23,17 +25,28 @@ class BaseModel(object):
         - fit(X_train, y_train, train_mode)
         - predict_proba(one_sample)
         - predict_class(one_sample)
+        - predict_proba_batch(samples)
         - test(X_test, y_test)
         - load_model_dump(path)
         - save_model_dump(path)
         - create_new_model(model_parameters)
 
+    And optionally (for in-process evaluation by authentication system):
+
+        - get_native_model(check_samples)
+
     """
 
     TRAIN_MODES         = ['multiclass', 'one-vs-all']
     CREATE_MODEL_MODES  = ['load', 'create']
     PREDICT_MODES       = ['probabilities', 'class-id']
 
+    # native model file (according to source/native_model.h)
+    NATIVE_MODEL_HEADER_FORMAT  = '<4s7I'
+    NATIVE_MODEL_MAGIC          = 'VASM'
+    NATIVE_MODEL_VERSION        = 1
+    NATIVE_MODEL_CHECK_SAMPLES  = 16
+
     def __init__(self, path_to_dump):
         if not path_to_dump:
             raise Exception('BaseModel::__init__(...). Incorrect "path_to_dump" parameter value.')
@@ -47,6 +60,9 @@ class BaseModel(object):
         # dump and load that data when dumping and loading model
         self.model_secondary_data_dump_filename = self.path_to_dump[:self.path_to_dump.rfind('/') + 1] + 'secondary_model_data.dump'
 
+        # model exported for in-process evaluation (according to settings.h)
+        self.native_model_dump_filename = self.path_to_dump[:self.path_to_dump.rfind('/') + 1] + 'trained_model.native'
+
 
     def _save_model_secondary_data(self):
         """
@@ -62,6 +78,69 @@ class BaseModel(object):
         with open(self.model_secondary_data_dump_filename, 'r') as inf:
             self.model_secondary_data = json.load(inf)
 
+    def get_native_model(self, check_samples):
+        """
+        Model in format of in-process evaluator (see source/native_model.h).
+        Models which can not be evaluated in-process return None.
+
+        :param check_samples - several preprocessed samples
+        :return              (native model type, model outputs on check samples, packed model data) or None
+        """
+        return None
+
+    def save_native_model_dump(self, check_samples):
+        """
+        Save model for in-process evaluation by authentication system (see source/native_model.h).
+        If model can not be exported nothing is written (python model is used by system then).
+
+        :param check_samples - several preprocessed train samples. Model outputs on them are saved too,
+                               native evaluator compares its outputs with them when model is loaded
+        """
+        # native model of previous training must not be used with new dump
+        if os.path.exists(self.native_model_dump_filename):
+            os.remove(self.native_model_dump_filename)
+
+        preprocess_type = int(self.model_secondary_data.get('preprocess_routine_type', 0))
+        preprocess_main_class = self.model_secondary_data.get('preprocess_main_voice_class', None)
+        preprocess_statistics = []
+
+        if preprocess_type == 1 and preprocess_main_class is not None:
+            preprocess_statistics = self.model_secondary_data['preprocess_routine_secondary_data']
+        elif preprocess_type not in (0, 1):
+            print 'BaseModel::save_native_model_dump(). Preprocess {} can not be done in-process, model is not exported.'.format(preprocess_type)
+            return
+
+        check_samples = np.asarray(check_samples, dtype='<f4')
+        native_model = self.get_native_model(check_samples)
+        if native_model is None:
+            return
+
+        model_type, check_outputs, model_data = native_model
+        check_outputs = np.asarray(check_outputs, dtype='<f4')
+
+        header = struct.pack(
+            BaseModel.NATIVE_MODEL_HEADER_FORMAT
+            , BaseModel.NATIVE_MODEL_MAGIC
+            , BaseModel.NATIVE_MODEL_VERSION
+            , model_type
+            , check_samples.shape[1]
+            , check_outputs.shape[1]
+            , preprocess_type
+            , len(preprocess_statistics[0]) if preprocess_statistics else 0
+            , len(check_samples)
+        )
+
+        # write into temporary file, so system never sees half written model
+        temporary_filename = self.native_model_dump_filename + '.tmp'
+        with open(temporary_filename, 'wb') as outf:
+            outf.write(header)
+            for statistics in preprocess_statistics:
+                outf.write(np.asarray(statistics, dtype='<f4').tostring())
+            outf.write(check_samples.tostring())
+            outf.write(check_outputs.tostring())
+            outf.write(model_data)
+        os.rename(temporary_filename, self.native_model_dump_filename)
+
     def _check_input_data(self, X, y):
         """
         Minor training data format checks
@@ -118,6 +197,7 @@ class BaseModel(object):
         
         self.save_model_dump()
         self._save_model_secondary_data()
+        self.save_native_model_dump(X_train[:BaseModel.NATIVE_MODEL_CHECK_SAMPLES])
 
     def load_and_test(self, X_test, y_test):
         """
@@ -154,6 +234,28 @@ class BaseModel(object):
         return prediction
 
 
+    def predict_wav_frames(self, frames_features, predict_mode='probabilities'):
+        """
+        Testing already trained model with features of all frames of one wav file at once
+        (one model call for all frames instead of call per frame)
+
+        :param frames_features - features of test wav file frames (one row per frame)
+        :param predict_mode    - specifying output format (see possible modes in BaseModel::PREDICT_MODES)
+        :return                Probabilities of each class for each frame or class id of each frame
+                               (class with max probability, counting from 1 as in run_auth.py)
+        """
+        if predict_mode.lower() not in BaseModel.PREDICT_MODES:
+            raise Exception(
+                'BaseModel::predict_wav_frames(...). Invalid "predict_mode" parameter value (got {0} expected one of {1})'.format(
+                    predict_mode, BaseModel.PREDICT_MODES
+            ))
+
+        probabilities = self.predict_proba_batch(np.asarray(frames_features))
+        if predict_mode == 'probabilities':
+            return probabilities
+        return np.argmax(probabilities, axis=1) + 1
+
+
 class NeuralNetModel(BaseModel):
     def __init__(
         self
@@ -180,6 +282,11 @@ class NeuralNetModel(BaseModel):
         model.compile(loss=self.loss, optimizer=self.optimizer, metrics=self.metrics)
         self.model = model
 
+    # keras activations -> source/dense_network.h::ACTIVATION
+    NATIVE_ACTIVATIONS = {
+        'linear': 0, 'relu': 1, 'sigmoid': 2, 'softmax': 3, 'tanh': 4
+    }
+
     def load_model_dump(self):
         self.model = keras.models.load_model(self.path_to_dump)
 
@@ -195,13 +302,35 @@ class NeuralNetModel(BaseModel):
     def predict_class(self, test_sample):
         return self.model.predict_classes(test_sample)
 
+    def predict_proba_batch(self, test_samples):
+        return self.model.predict(test_samples, verbose=0)
+
     def test(self, X_test, y_test):
         return zip(self.model.metrics_names, self.model.evaluate(X_test, y_test, verbose=False))
 
+    def get_native_model(self, check_samples):
+        """
+        Dense layers one after another (see source/dense_network.h)
+        """
+        layers_data = []
+        for layer in self.model.layers:
+            activation = layer.get_config().get('activation', None)
+            if not isinstance(layer, keras.layers.Dense) or activation not in NeuralNetModel.NATIVE_ACTIVATIONS:
+                return None
+
+            weights, biases = layer.get_weights()
+            layers_data.append(
+                struct.pack('<4I', weights.shape[0], weights.shape[1], NeuralNetModel.NATIVE_ACTIVATIONS[activation], 0)
+                + np.asarray(weights, dtype='<f4').tostring()
+                + np.asarray(biases, dtype='<f4').tostring()
+            )
+
+        return 0, self.predict_proba_batch(check_samples), struct.pack('<I', len(layers_data)) + ''.join(layers_data)
+
 
 class RandomForestModel(BaseModel):
     def __init__(self, path_to_dump, n_estimators=300):
-        super(NeuralNetModel, self).__init__(path_to_dump)
+        super(RandomForestModel, self).__init__(path_to_dump)
 
         self.n_estimators = n_estimators
 
@@ -220,10 +349,54 @@ class RandomForestModel(BaseModel):
         self.model.fit(X_train, y_train)
 
     def predict_proba(self, test_sample):
-        return self.model.predict_proba([features])[0]
+        return self.model.predict_proba(test_sample)[0]
 
     def predict_class(self, test_sample):
-        return self.model.predict([features])[0]
+        return self.model.predict(test_sample)[0]
+
+    def predict_proba_batch(self, test_samples):
+        return self.model.predict_proba(test_samples)
 
     def test(self, X_test, y_test):
         return self.model.score(X_test, y_test)
+
+    def get_native_model(self, check_samples):
+        """
+        Nodes of all trees in flat arrays (see source/random_forest.h)
+        """
+        trees = [estimator.tree_ for estimator in self.model.estimators_]
+
+        roots, features, thresholds, left_children, right_children, leaves = [], [], [], [], [], []
+        number_of_nodes, number_of_leaves = 0, 0
+
+        for tree in trees:
+            is_leaf = tree.children_left == -1
+            leaf_index = number_of_leaves + np.cumsum(is_leaf) - 1
+
+            # leaf: feature -1, both children - index of leaf probabilities
+            roots.append(number_of_nodes)
+            features.append(np.where(is_leaf, -1, tree.feature))
+            left_children.append(np.where(is_leaf, leaf_index, number_of_nodes + tree.children_left))
+            right_children.append(np.where(is_leaf, leaf_index, number_of_nodes + tree.children_right))
+
+            # samples are float32: 'x <= threshold' is the same as 'x <= largest float32 not greater than threshold'
+            tree_thresholds = tree.threshold.astype(np.float32)
+            rounded_up = tree_thresholds.astype(np.float64) > tree.threshold
+            tree_thresholds[rounded_up] = np.nextafter(tree_thresholds[rounded_up], np.float32(-np.inf))
+            thresholds.append(tree_thresholds)
+
+            leaf_values = tree.value[is_leaf][:, 0, :].astype(np.float64)
+            leaves.append(leaf_values / leaf_values.sum(axis=1, keepdims=True))
+
+            number_of_nodes += tree.node_count
+            number_of_leaves += int(is_leaf.sum())
+
+        model_data = struct.pack('<3I', len(trees), number_of_nodes, number_of_leaves)
+        model_data += np.asarray(roots, dtype='<i4').tostring()
+        model_data += np.concatenate(features).astype('<i4').tostring()
+        model_data += np.concatenate(thresholds).astype('<f4').tostring()
+        model_data += np.concatenate(left_children).astype('<i4').tostring()
+        model_data += np.concatenate(right_children).astype('<i4').tostring()
+        model_data += np.concatenate(leaves).astype('<f4').tostring()
+
+        return 1, self.predict_proba_batch(check_samples), model_data
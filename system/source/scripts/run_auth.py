@@ -87,26 +87,28 @@ def fit(
         print 'Test result: {0}'.format(test_result)
 
 
-def predict(
-    testing_record_features_path
-    , path_to_saved_model_dump
-    , path_to_store_result
-    , model_name='NN'
-):
-    # create specified model
+def load_model(path_to_saved_model_dump, model_name='NN'):
+    """
+    Load trained model (with its secondary data) from dump.
+    """
     if model_name == 'NN':
         model = models.NeuralNetModel(path_to_saved_model_dump)
     elif model_name == 'RF':
         model = models.RandomForestModel(path_to_saved_model_dump)
     else:
-        raise Exception('py_run_auth::train(...). Invalid "model_name" parameter ({0})'.format(model_name))
+        raise Exception('py_run_auth::load_model(...). Invalid "model_name" parameter ({0})'.format(model_name))
     model.load_or_create(create_mode='load')
+    return model
 
-    # log
-    print 'Running test procedure with:\n - model dump from: {}\n'.format(
-        path_to_saved_model_dump
-    )
 
+def classify_wav_features(model, test_frames_features):
+    """
+    Classify frames of wav file (all at once) and combine results (most common frame class).
+
+    :param model                - model loaded with load_model(...)
+    :param test_frames_features - features of wav file frames (not preprocessed)
+    :return                     class of wav file
+    """
     # load data for preprocess from model secondary data
     preprocess_type = model.model_secondary_data['preprocess_routine_type']
     preprocess_main_class = model.model_secondary_data['preprocess_main_voice_class']
@@ -114,14 +116,6 @@ def predict(
 
     preprocess_function = FEATURES_PREPROCESS.get(int(preprocess_type), None)
 
-    # log
-    print 'Running test procedure with:\n - model dump from: {}\n - preprocess function: {}\n - preprocess data: {}\n'.format(
-        path_to_saved_model_dump, preprocess_function.__name__, preprocess_secondary_data
-    )
-
-    # load wav file features
-    test_frames_features = load_test_wav_features(testing_record_features_path)
-
     # run features preprocess procedure
     test_frames_features = preprocess_function(
         test_frames_features
@@ -131,26 +125,83 @@ def predict(
         , preprocess_help_data=preprocess_secondary_data
     )
 
-    # run classification
-    count_decisions = Counter()
-
-    # classify each frame
-    for frame_features in test_frames_features:
-        classification_results = model.predict_one_wav(np.array([frame_features]), predict_mode='probabilities')
-        result_class = np.argmax(classification_results) + 1
-        count_decisions[result_class] += 1
-        # print result_class, classification_results
+    # classify all frames at once
+    frames_classes = model.predict_wav_frames(test_frames_features, predict_mode='class-id')
+    count_decisions = Counter(int(frame_class) for frame_class in frames_classes)
 
     # combine each frame classification results
     result_class = count_decisions.most_common(1)[0][0]
 
     assert(result_class is not None)
+    return result_class
+
+
+def predict(
+    testing_record_features_path
+    , path_to_saved_model_dump
+    , path_to_store_result
+    , model_name='NN'
+):
+    # create specified model
+    model = load_model(path_to_saved_model_dump, model_name)
+
+    # log
+    print 'Running test procedure with:\n - model dump from: {}\n - preprocess type: {}\n - preprocess data: {}\n'.format(
+        path_to_saved_model_dump
+        , model.model_secondary_data['preprocess_routine_type']
+        , model.model_secondary_data['preprocess_routine_secondary_data']
+    )
+
+    # load wav file features and classify them
+    result_class = classify_wav_features(model, load_test_wav_features(testing_record_features_path))
+
     with open(path_to_store_result, 'w') as outf:
         outf.write(str(result_class))
 
 
+def serve():
+    """
+    Scoring loop of authentication server (see system/source/server.h).
+
+    Reads requests from stdin, one per line:
+        predict <features_path> <model_dump_path> <model_name>
+        load <model_dump_path> <model_name>
+    and answers each of them with one line: 'result <class>' or 'error <message>'
+    (anything else printed to stdout is ignored by server).
+
+    Models are loaded on first request to them and stay in memory.
+    """
+    loaded_models = {}
+
+    for line in iter(sys.stdin.readline, ''):
+        request = line.split()
+        if not request:
+            continue
+
+        try:
+            if not (request[0] == 'predict' and len(request) == 4) and not (request[0] == 'load' and len(request) == 3):
+                raise Exception('invalid request "{}"'.format(line.strip()))
+
+            model_dump_path, model_name = request[-2:]
+            if (model_dump_path, model_name) not in loaded_models:
+                loaded_models[(model_dump_path, model_name)] = load_model(model_dump_path, model_name)
+
+            if request[0] == 'load':
+                answer = 'result 0'
+            else:
+                result_class = classify_wav_features(loaded_models[(model_dump_path, model_name)], load_test_wav_features(request[1]))
+                answer = 'result {}'.format(result_class)
+        except Exception as e:
+            answer = 'error {}'.format(str(e).replace('\n', ' '))
+
+        sys.stdout.write(answer + '\n')
+        sys.stdout.flush()
+
+
 if __name__ == '__main__':
     if sys.argv[1] == 'fit':
         fit(*sys.argv[2:])
     elif sys.argv[1] == 'predict':
         predict(*sys.argv[2:])
+    elif sys.argv[1] == 'serve':
+        serve()
@@ -133,8 +133,8 @@ def split_on_train_test(path_to_wav_files, path_to_train, path_to_test, test_siz
         for filename in os.listdir(folder_absolute_path):
             absolute_filepath = os.path.join(folder_absolute_path, filename)
 
-            # open to find out size
-            rate, signal = wav.read(absolute_filepath)
+            # open to find out size (memory mapped, samples are not loaded)
+            rate, signal = wav.read(absolute_filepath, mmap=True)
             
             # split on trian and test
             split_and_save_one_file(
@@ -166,25 +166,6 @@ def delete_old_data(path_to_storage, path_to_train_folder, path_to_test_folder):
         os.mkdir(os.path.join(path_to_test_folder, folder_name))
 
 
-def split_wav_file(original_wav_file_path, number_of_parts):
-    """
-    Split given wav file into given number of parts (separate wav files)
-    
-    :param original_wav_file_path:  path to wav file to split
-    :param number_of_parts:         number of new wav files (original wav files parts)
-    """
-
-    rate, original_signal = wav.read(original_wav_file_path)
-    one_part_size = len(original_signal) / number_of_parts
-
-    for part_number in xrange(number_of_parts):
-        wav.write(
-            original_wav_file_path.replace('.wav', '_part_{}.wav'.format(part_number))
-            , rate
-            , original_signal[part_number * one_part_size : min(len(original_signal), (part_number + 1) * one_part_size)]
-        )
-
-
 #
 #   Main script interface
 #
@@ -210,51 +191,5 @@ def create_train_test(
     augmentate_data([path_to_train, path_to_test])
 
 
-def split_big_storage_files(
-    path_to_storage='/home/kolegor/Code/VAS/data/storage/'
-    , file_size_threshold=35000000  # 35MB
-):
-    """
-    Big wav files (more that 30-40MB or more than 5-6 minutes) are causing memory error.
-    Split those files in parts. Leave save filename, only adding 'part_x' suffix (x - part_number)
-
-    Also check folder names to be in format "voice_###_@", where ### - any string in any format
-    and @ - voice class (integer) from 0 to infty
-
-    :param path_to_storage:         global storage folder
-    :param file_size_threshold:     split wav file if size of file more than this threshold (bytes)
-    """
-
-    folder_name_pattern = re.compile('voice_(.*?)_\d+$')
-
-    for folder_name in os.listdir(path_to_storage):
-        absolute_folder_path = os.path.join(path_to_storage, folder_name)
-
-        # check only folders
-        if not os.path.isdir(absolute_folder_path):
-            continue
-
-        # check folder_name format
-        #if folder_name_pattern.match(folder_name) is None:
-        #    raise Exception('Invalid folder name: {}'.format(folder_name))
-
-        for file_name in os.listdir(absolute_folder_path):
-            absolute_file_path = os.path.join(absolute_folder_path, file_name)
-            # check only wav files
-            if not file_name.endswith('.wav'):
-                continue
-
-            file_size = os.path.getsize(absolute_file_path)
-
-            # split if size bigger that threshold
-            if file_size > file_size_threshold:
-                nb_parts = int(file_size / (0.9 * file_size_threshold)) + 1
-                split_wav_file(absolute_file_path, nb_parts)
-
-            # delete original file (we have parts now)
-            os.remove(absolute_file_path)
-
-
 if __name__ == '__main__':
-    split_big_storage_files()
     create_train_test()
@@ -2,7 +2,6 @@ import numpy as np
 import struct
 import ctypes
 import scipy.io.wavfile as wav
-import pandas
 
 
 def normilize_wav(signal):
@@ -20,16 +19,75 @@ def get_wav_amplitudes(path_to_wav_file, normilize=True):
     return rate, signal
 
 
+# binary features files layout (see system/source/features_file.h)
+FEATURES_FILE_HEADER_FORMAT = '<4s9IQ'
+FEATURES_FILE_HEADER_FIELDS = [
+    'magic', 'version', 'number_of_features', 'number_of_mfcc_features', 'number_of_fbank_features'
+    , 'frame_length', 'frame_step', 'sample_rate', 'normalize', 'reserved', 'number_of_frames'
+]
+FEATURES_FILE_HEADER_SIZE = struct.calcsize(FEATURES_FILE_HEADER_FORMAT)
+FEATURES_FILE_MAGIC = 'VASF'
+DATASET_FILE_MAGIC = 'VASD'
+FEATURES_FILE_VERSION = 1
+
+
+def read_features_header(filepath, expected_magic=FEATURES_FILE_MAGIC):
+    """
+    Read header of binary features (or dataset) file.
+
+    :return dict with FEATURES_FILE_HEADER_FIELDS keys
+    """
+    with open(filepath, 'rb') as inf:
+        raw_header = inf.read(FEATURES_FILE_HEADER_SIZE)
+
+    if len(raw_header) != FEATURES_FILE_HEADER_SIZE:
+        raise Exception('utilities::read_features_header(...). File is too small: {}'.format(filepath))
+
+    header = dict(zip(FEATURES_FILE_HEADER_FIELDS, struct.unpack(FEATURES_FILE_HEADER_FORMAT, raw_header)))
+    if header['magic'] != expected_magic or header['version'] != FEATURES_FILE_VERSION:
+        raise Exception('utilities::read_features_header(...). Invalid features file: {}'.format(filepath))
+    return header
+
+
+def load_features_file(filepath, expected_magic=FEATURES_FILE_MAGIC):
+    """
+    Memory map binary features (or dataset) file. Rows are not copied until changed (copy-on-write).
+
+    :return header, features matrix (number_of_frames x number_of_features, float32)
+    """
+    header = read_features_header(filepath, expected_magic)
+    shape = (header['number_of_frames'], header['number_of_features'])
+
+    if shape[0] == 0:
+        return header, np.zeros(shape, dtype=np.float32)
+    return header, np.memmap(filepath, dtype='<f4', mode='c', offset=FEATURES_FILE_HEADER_SIZE, shape=shape)
+
+
+def save_features_file(filepath, features, frame_length, frame_step, nb_mfcc_features, nb_fbank_features, sample_rate, normilize):
+    """
+    Write features rows as binary features file.
+    """
+    features = np.asarray(features, dtype='<f4').reshape(len(features), -1)
+    header = struct.pack(
+        FEATURES_FILE_HEADER_FORMAT
+        , FEATURES_FILE_MAGIC, FEATURES_FILE_VERSION, features.shape[1], nb_mfcc_features, nb_fbank_features
+        , frame_length, frame_step, sample_rate, 1 if normilize else 0, 0, features.shape[0]
+    )
+    with open(filepath, 'wb') as outf:
+        outf.write(header)
+        outf.write(features.tobytes())
+
+
 def load_file_info(filepath):
     """
-    Read train data. Expecting header.
+    Read train (or test) data - dataset file created by DatasetBuilder (see system/source/dataset_builder.h).
     """
-    df, X = pandas.read_csv(filepath), []
-    for record in df['Features'].values:
-        X.extend([float(a) for a in record.split(' ')])
+    header, X = load_features_file(filepath, DATASET_FILE_MAGIC)
 
-    X = np.array(X).reshape(len(df), (len(X) / len(df)))
-    y = df['Class'].values
+    labels_offset = FEATURES_FILE_HEADER_SIZE + X.size * 4
+    y = np.zeros(0, dtype=np.int32)
+    if len(X):
+        y = np.array(np.memmap(filepath, dtype='<i4', mode='r', offset=labels_offset, shape=(len(X),)))
 
     if 0 not in y:
         y = y - 1
@@ -40,12 +98,7 @@ def load_test_wav_features(path_to_features):
     """
     Loading test data
     """
-    with open(path_to_features, 'r') as inf:
-        lines = []
-        for line in inf:
-            lines.append(list(map(float, filter(lambda x: len(x.strip()) > 0, line.split(' ')))))
-
-        return np.array(lines)
+    return load_features_file(path_to_features)[1]
 
 
 class FeaturesPreprocess:
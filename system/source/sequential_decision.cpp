@@ -0,0 +1,114 @@
+#include "sequential_decision.h"
+
+
+const int SequentialDecision::BLOCK_FRAMES = 8;
+const double SequentialDecision::MIN_PROBABILITY = 1e-7;
+
+
+DecisionParameters::DecisionParameters(DECISION_RULE set_rule, double set_threshold)
+	: rule(set_rule)
+	, threshold(set_threshold)
+{ }
+
+
+SequentialDecision::SequentialDecision(int number_of_classes, const DecisionParameters& parameters)
+	: number_of_classes_(number_of_classes)
+	, parameters_(parameters)
+	, votes_(number_of_classes + 1, 0)
+	, log_likelihoods_(number_of_classes + 1, 0.0)
+	, number_of_frames_(0)
+	, decided_class_(0)
+{
+	if(number_of_classes < 1){
+		throw std::invalid_argument("SequentialDecision needs at least one class");
+	}
+}
+
+
+/*
+*	Main interface
+*/
+
+bool SequentialDecision::add_frames(const float* probabilities, long long number_of_rows){
+	for(long long row = 0; row < number_of_rows && !this->decided_class_; ++row){
+		const float* row_probabilities = probabilities + row * this->number_of_classes_;
+
+		++this->votes_[std::max_element(row_probabilities, row_probabilities + this->number_of_classes_) - row_probabilities + 1];
+		for(int index = 0; index < this->number_of_classes_; ++index){
+			this->log_likelihoods_[index + 1] += std::log(std::max<double>(row_probabilities[index], MIN_PROBABILITY));
+		}
+		++this->number_of_frames_;
+
+		// one class only - nothing to compare with
+		if(this->number_of_classes_ < 2){
+			continue;
+		}
+
+		int leader;
+		if(this->parameters_.rule == DECISION_RULE::VOTE_MARGIN && get_leader_margin(this->votes_, leader) >= this->parameters_.threshold){
+			this->decided_class_ = leader;
+		}
+		else if(this->parameters_.rule == DECISION_RULE::LIKELIHOOD_RATIO && get_leader_margin(this->log_likelihoods_, leader) >= this->parameters_.threshold){
+			this->decided_class_ = leader;
+		}
+	}
+
+	return this->decided_class_ != 0;
+}
+
+int SequentialDecision::get_class() const{
+	if(this->decided_class_){
+		return this->decided_class_;
+	}
+	if(this->number_of_frames_ == 0){
+		throw std::runtime_error("No frames to classify");
+	}
+
+	return std::max_element(this->votes_.begin() + 1, this->votes_.end()) - this->votes_.begin();
+}
+
+bool SequentialDecision::is_decided() const{
+	return this->decided_class_ != 0;
+}
+
+long long SequentialDecision::get_number_of_frames() const{
+	return this->number_of_frames_;
+}
+
+void SequentialDecision::decide(const std::function<bool(FrameSamples&)>& next_frame, const FeaturesEngine& engine, const NativeModel& model){
+	if(engine.get_number_of_features() != model.get_input_dimension()){
+		throw std::runtime_error("Features do not match model input");
+	}
+
+	int number_of_features = engine.get_number_of_features();
+	bool streamable = model.is_streamable();
+
+	FeaturesWorkspace workspace;
+	FrameSamples frame;
+	std::vector<double> row(number_of_features);
+	std::vector<float> rows, probabilities;
+
+	bool frames_ended = false;
+	while(!frames_ended && !this->is_decided()){
+		rows.clear();
+		while(!frames_ended && (!streamable || static_cast<int>(rows.size()) < BLOCK_FRAMES * number_of_features)){
+			if(!next_frame(frame)){
+				frames_ended = true;
+				break;
+			}
+
+			engine.prepare_frame(frame.samples.data(), frame.valid_samples, frame.has_previous ? &frame.previous_sample : nullptr, workspace);
+			engine.compute_frame(workspace, row.data());
+			rows.insert(rows.end(), row.begin(), row.end());
+		}
+
+		long long number_of_rows = rows.size() / number_of_features;
+		if(number_of_rows == 0){
+			break;
+		}
+
+		probabilities.resize(number_of_rows * model.get_number_of_classes());
+		model.score_frames_proba(rows.data(), number_of_rows, probabilities.data());
+		this->add_frames(probabilities.data(), number_of_rows);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "../settings.h"
+#include "features_engine.h"
+#include "native_model.h"
+#include "wav_file.h"
+
+
+struct DecisionParameters{
+
+	/*
+	*	When class of wav file is decided (see SequentialDecision)
+	*/
+
+	DECISION_RULE rule;
+	double threshold;						// votes margin or log-likelihood ratio (depends on rule)
+
+
+public:
+
+	DecisionParameters(DECISION_RULE set_rule = DECISION_RULE::ALL_FRAMES, double set_threshold = 0.0);
+};
+
+
+class SequentialDecision{
+
+	/*
+	*	Decision about class of wav file, made while its frames are scored. Frames are added
+	*	as they come and wav file is decided as soon as one class is confidently ahead:
+	*	 - VOTE_MARGIN: leading class got at least 'threshold' more frames votes than any other class
+	*	 - LIKELIHOOD_RATIO: log probabilities of frames are summed for each class, sum of leading
+	*	   class is at least 'threshold' more than sum of any other class (log-likelihood ratio)
+	*	 - ALL_FRAMES: never decided before all frames are added
+	*
+	*	If frames end before decision, class is the most common class of all frames
+	*	(same as scripts/run_auth.py::classify_wav_features).
+	*/
+
+private:
+
+	static const int BLOCK_FRAMES;				// frames extracted and scored at once in decide(...)
+	static const double MIN_PROBABILITY;		// probabilities are clipped to it before log
+
+	int number_of_classes_;
+	DecisionParameters parameters_;
+
+	std::vector<long long> votes_;				// number of frames of each class (classes start with 1)
+	std::vector<double> log_likelihoods_;		// sum of log probabilities of frames for each class
+	long long number_of_frames_;
+	int decided_class_;							// 0 if not decided yet
+
+	// difference between best and second best value (classes from 1 to number_of_classes)
+	template<typename T>
+	static double get_leader_margin(const std::vector<T>& values, int& leader);
+
+
+public:
+
+	SequentialDecision(int number_of_classes, const DecisionParameters& parameters = DecisionParameters());
+
+	// add probabilities of classes of next frames (number_of_rows x number_of_classes). True if class is decided
+	bool add_frames(const float* probabilities, long long number_of_rows);
+
+	// decided class, or most common class of frames added so far (smaller class on tie)
+	int get_class() const;
+
+	bool is_decided() const;
+
+	long long get_number_of_frames() const;
+
+	// extract and score frames from source until class is decided or frames end. Frames are
+	// scored in small blocks, so source is not read further than needed. Models which need all
+	// frames at once (see NativeModel::is_streamable) get them all
+	void decide(const std::function<bool(FrameSamples&)>& next_frame, const FeaturesEngine& engine, const NativeModel& model);
+};
+
+
+template<typename T>
+double SequentialDecision::get_leader_margin(const std::vector<T>& values, int& leader){
+	leader = std::max_element(values.begin() + 1, values.end()) - values.begin();
+
+	double second = -INFINITY;
+	for(size_t index = 1; index < values.size(); ++index){
+		if(static_cast<int>(index) != leader){
+			second = std::max(second, static_cast<double>(values[index]));
+		}
+	}
+	return values[leader] - second;
+}
@@ -0,0 +1,478 @@
+#include "server.h"
+
+
+//----------------------------------------------------------------------------------------------------
+//	Scorer process
+//----------------------------------------------------------------------------------------------------
+
+
+ScorerProcess::ScorerProcess()
+	: pid_(-1)
+	, to_scorer_(-1)
+	, from_scorer_(-1)
+{ }
+
+ScorerProcess::~ScorerProcess(){
+	this->stop();
+}
+
+void ScorerProcess::start(){
+	int input_pipe[2];			// server -> scorer
+	int output_pipe[2];			// scorer -> server
+
+	// parent ends must not leak into next scorer process (dup2 clears flag for child ends)
+	if(pipe2(input_pipe, O_CLOEXEC) != 0){
+		throw std::runtime_error("Can't create pipe for scorer process");
+	}
+	if(pipe2(output_pipe, O_CLOEXEC) != 0){
+		close(input_pipe[0]);
+		close(input_pipe[1]);
+		throw std::runtime_error("Can't create pipe for scorer process");
+	}
+
+	pid_t pid = fork();
+	if(pid < 0){
+		close(input_pipe[0]);
+		close(input_pipe[1]);
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+		throw std::runtime_error("Can't start scorer process");
+	}
+
+	if(pid == 0){
+		dup2(input_pipe[0], STDIN_FILENO);
+		dup2(output_pipe[1], STDOUT_FILENO);
+		close(input_pipe[0]);
+		close(input_pipe[1]);
+		close(output_pipe[0]);
+		close(output_pipe[1]);
+
+		execlp("python", "python", SETTINGS::PYTHON_MODEL_TRAINING_SCRIPT_PATH.c_str(), "serve", static_cast<char*>(nullptr));
+		_exit(127);
+	}
+
+	close(input_pipe[0]);
+	close(output_pipe[1]);
+
+	this->pid_ = pid;
+	this->to_scorer_ = input_pipe[1];
+	this->from_scorer_ = output_pipe[0];
+	this->read_buffer_.clear();
+}
+
+void ScorerProcess::stop(){
+	if(this->pid_ < 0){
+		return;
+	}
+
+	// scorer exits when its stdin is closed
+	close(this->to_scorer_);
+	close(this->from_scorer_);
+	waitpid(this->pid_, nullptr, 0);
+
+	this->pid_ = -1;
+	this->to_scorer_ = -1;
+	this->from_scorer_ = -1;
+}
+
+std::string ScorerProcess::read_line(){
+	size_t line_end;
+	while((line_end = this->read_buffer_.find('\n')) == std::string::npos){
+		char buffer[4096];
+		ssize_t bytes_read = read(this->from_scorer_, buffer, sizeof(buffer));
+		if(bytes_read < 0 && errno == EINTR){
+			continue;
+		}
+		if(bytes_read <= 0){
+			throw std::runtime_error("Scorer process exited");
+		}
+		this->read_buffer_.append(buffer, bytes_read);
+	}
+
+	std::string line = this->read_buffer_.substr(0, line_end);
+	this->read_buffer_.erase(0, line_end + 1);
+	return line;
+}
+
+std::string ScorerProcess::request(const std::string& request){
+	std::lock_guard<std::mutex> lock(this->m_scorer_lock_);
+
+	std::string request_line = request + "\n";
+
+	// two attempts: scorer may have exited since last request
+	for(int attempt = 0; attempt < 2; ++attempt){
+		try{
+			if(this->pid_ < 0){
+				this->start();
+			}
+
+			if(write(this->to_scorer_, request_line.data(), request_line.size()) != static_cast<ssize_t>(request_line.size())){
+				throw std::runtime_error("Scorer process exited");
+			}
+
+			// skip everything scorer (or libraries it uses) prints besides answers
+			while(true){
+				std::string line = this->read_line();
+				if(line.compare(0, 7, "result ") == 0){
+					return line.substr(7);
+				}
+				if(line.compare(0, 6, "error ") == 0){
+					throw std::invalid_argument(line.substr(6));
+				}
+			}
+		}
+		catch(std::invalid_argument& e){
+			// scorer is fine, request is not
+			throw std::runtime_error(e.what());
+		}
+		catch(std::exception& e){
+			this->stop();
+			if(attempt == 1){
+				throw;
+			}
+		}
+	}
+
+	throw std::runtime_error("Scorer process exited");
+}
+
+void ScorerProcess::load_model(const std::string& model_dump_path, const std::string& model_name){
+	this->request("load " + model_dump_path + " " + model_name);
+}
+
+int ScorerProcess::classify(const std::string& features_filepath, const std::string& model_dump_path, const std::string& model_name){
+	return std::stoi(this->request("predict " + features_filepath + " " + model_dump_path + " " + model_name));
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Authentication server
+//----------------------------------------------------------------------------------------------------
+
+
+AuthenticationServer::AuthenticationServer(
+	const std::string& socket_path
+	, const FeaturesParameters& parameters
+	, const std::string& default_model_folder
+	, const std::string& model_name
+	, const DecisionParameters& decision_parameters
+)
+	: socket_path_(socket_path)
+	, default_model_folder_(default_model_folder)
+	, model_name_(model_name)
+	, engine_(parameters)
+	, decision_parameters_(decision_parameters)
+	, listen_socket_(-1)
+	, stopped_(false)
+	, requests_counter_(0)
+{ }
+
+AuthenticationServer::~AuthenticationServer(){
+	if(this->listen_socket_ >= 0){
+		close(this->listen_socket_);
+		unlink(this->socket_path_.c_str());
+	}
+}
+
+std::shared_ptr<NativeModel> AuthenticationServer::get_native_model(const std::string& model_folder){
+	std::string native_model_filepath = model_folder + SETTINGS::NATIVE_MODEL_OUTPUT_NAME;
+	if(!boost::filesystem::exists(native_model_filepath)){
+		return nullptr;
+	}
+
+	std::lock_guard<std::mutex> lock(this->m_native_models_lock_);
+
+	std::time_t modification_time = boost::filesystem::last_write_time(native_model_filepath);
+	auto loaded = this->native_models_.find(model_folder);
+	if(loaded != this->native_models_.end() && loaded->second.modification_time == modification_time){
+		return loaded->second.model;
+	}
+
+	try{
+		LoadedNativeModel native_model;
+		native_model.modification_time = modification_time;
+		native_model.model = std::shared_ptr<NativeModel>(NativeModel::load(native_model_filepath));
+		native_model.model->set_number_of_threads(std::thread::hardware_concurrency());
+		this->native_models_[model_folder] = native_model;
+		return native_model.model;
+	}
+	catch(std::exception& e){
+		std::cout << "AuthenticationServer::get_native_model(...). Native model can't be used, running python model.\n";
+		std::cout << e.what() << '\n';
+		return nullptr;
+	}
+}
+
+std::string AuthenticationServer::handle_request(const std::string& request){
+	std::istringstream request_stream(request);
+	std::string command;
+	request_stream >> command;
+
+	if(command == "ping"){
+		return "ok";
+	}
+
+	if(command == "shutdown"){
+		this->stopped_ = true;
+		// wake up accept(...)
+		shutdown(this->listen_socket_, SHUT_RDWR);
+		return "ok";
+	}
+
+	if(command != "predict"){
+		return "error unknown command '" + command + "'";
+	}
+
+	std::string wav_filepath, model_folder;
+	request_stream >> wav_filepath >> model_folder;
+	if(wav_filepath.empty()){
+		return "error wav file is not specified";
+	}
+	if(model_folder.empty()){
+		model_folder = this->default_model_folder_;
+	}
+	if(model_folder.back() != '/'){
+		model_folder += '/';
+	}
+
+	try{
+		// native model: frames are scored while wav file is read (no features file)
+		std::shared_ptr<NativeModel> native_model = this->get_native_model(model_folder);
+		if(native_model){
+			const FeaturesParameters& parameters = this->engine_.get_parameters();
+			WavFrameReader frames_reader(wav_filepath, parameters.frame_length, parameters.frame_step);
+			if(!check_wav_file_format(frames_reader.get_header())){
+				return "error unsupported wav file format";
+			}
+
+			SequentialDecision decision(native_model->get_number_of_classes(), this->decision_parameters_);
+			decision.decide([&](FrameSamples& frame){ return frames_reader.next_frame(frame); }, this->engine_, *native_model);
+			return "ok " + std::to_string(decision.get_class());
+		}
+	}
+	catch(std::exception& e){
+		return std::string("error ") + e.what();
+	}
+
+	std::string features_filepath = SETTINGS::DATA_FOLDER + "_server_request_" + std::to_string(this->requests_counter_++) + SETTINGS::FEATURES_FILES_EXTENSION;
+
+	try{
+		this->engine_.extract_file(wav_filepath, features_filepath);
+		int result_class = this->scorer_.classify(features_filepath, model_folder + SETTINGS::MODEL_DUMP_OUTPUT_NAME, this->model_name_);
+		std::remove(features_filepath.c_str());
+		return "ok " + std::to_string(result_class);
+	}
+	catch(std::exception& e){
+		std::remove(features_filepath.c_str());
+		return std::string("error ") + e.what();
+	}
+}
+
+std::string AuthenticationServer::handle_stream(const std::string& request, int client_socket, const std::string& received_bytes){
+	std::istringstream request_stream(request);
+	std::string command, model_folder;
+	request_stream >> command >> model_folder;
+	if(model_folder.empty()){
+		model_folder = this->default_model_folder_;
+	}
+	if(model_folder.back() != '/'){
+		model_folder += '/';
+	}
+
+	try{
+		std::shared_ptr<NativeModel> native_model = this->get_native_model(model_folder);
+		if(!native_model){
+			return "error streaming needs native model";
+		}
+
+		const FeaturesParameters& parameters = this->engine_.get_parameters();
+		PcmStreamFrameReader frames_reader(
+			client_socket
+			, parameters.frame_length
+			, parameters.frame_step
+			, static_cast<long long>(parameters.sample_rate) * SETTINGS::MAX_STREAM_SECONDS
+			, received_bytes
+		);
+
+		SequentialDecision decision(native_model->get_number_of_classes(), this->decision_parameters_);
+		decision.decide([&](FrameSamples& frame){ return frames_reader.next_frame(frame); }, this->engine_, *native_model);
+		return "ok " + std::to_string(decision.get_class());
+	}
+	catch(std::exception& e){
+		return std::string("error ") + e.what();
+	}
+}
+
+void AuthenticationServer::handle_connection(int client_socket){
+	std::string buffer;
+	char chunk[4096];
+
+	while(true){
+		ssize_t bytes_read = recv(client_socket, chunk, sizeof(chunk), 0);
+		if(bytes_read < 0 && errno == EINTR){
+			continue;
+		}
+		if(bytes_read <= 0){
+			break;
+		}
+		buffer.append(chunk, bytes_read);
+
+		size_t line_end;
+		while((line_end = buffer.find('\n')) != std::string::npos){
+			std::string request = buffer.substr(0, line_end);
+			buffer.erase(0, line_end + 1);
+
+			// rest of connection is audio, answer is the last message
+			if(request.compare(0, 6, "stream") == 0){
+				std::string answer = this->handle_stream(request, client_socket, buffer) + "\n";
+				std::cout << "AuthenticationServer: " << answer << std::flush;
+				send(client_socket, answer.data(), answer.size(), MSG_NOSIGNAL);
+				close(client_socket);
+				return;
+			}
+
+			std::string answer = this->handle_request(request) + "\n";
+
+			std::cout << "AuthenticationServer: " << answer << std::flush;
+			if(send(client_socket, answer.data(), answer.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(answer.size())){
+				close(client_socket);
+				return;
+			}
+		}
+	}
+
+	close(client_socket);
+}
+
+int AuthenticationServer::connect_to(const std::string& socket_path){
+	sockaddr_un address;
+	if(socket_path.size() >= sizeof(address.sun_path)){
+		throw std::runtime_error("Socket path is too long: " + socket_path);
+	}
+
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, socket_path.c_str(), sizeof(address.sun_path) - 1);
+
+	int client_socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(client_socket < 0){
+		throw std::runtime_error("Can't create socket");
+	}
+
+	if(connect(client_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0){
+		close(client_socket);
+		return -1;
+	}
+	return client_socket;
+}
+
+
+/*
+*	Main interface
+*/
+
+void AuthenticationServer::run(){
+	/*
+	*	Each client connection is served by its own thread. Features are extracted
+	*	concurrently, models are run one request at a time (see ScorerProcess).
+	*/
+
+	if(is_running(this->socket_path_)){
+		std::cout << "AuthenticationServer::run(). Server is already running on " << this->socket_path_ << "\n";
+		throw std::runtime_error("Server is already running on " + this->socket_path_);
+	}
+
+	sockaddr_un address;
+	if(this->socket_path_.size() >= sizeof(address.sun_path)){
+		throw std::runtime_error("Socket path is too long: " + this->socket_path_);
+	}
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	std::strncpy(address.sun_path, this->socket_path_.c_str(), sizeof(address.sun_path) - 1);
+
+	// stale socket file of server which was killed
+	unlink(this->socket_path_.c_str());
+
+	this->listen_socket_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if(this->listen_socket_ < 0 || bind(this->listen_socket_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(this->listen_socket_, 16) != 0){
+		std::cout << "AuthenticationServer::run(). Can't listen on " << this->socket_path_ << ": " << std::strerror(errno) << "\n";
+		throw std::runtime_error("Can't listen on " + this->socket_path_);
+	}
+	chmod(this->socket_path_.c_str(), S_IRUSR | S_IWUSR);
+
+	// default model is loaded before first request
+	std::string default_model_dump = this->default_model_folder_ + SETTINGS::MODEL_DUMP_OUTPUT_NAME;
+	if(!this->get_native_model(this->default_model_folder_) && boost::filesystem::exists(default_model_dump)){
+		try{
+			this->scorer_.load_model(default_model_dump, this->model_name_);
+		}
+		catch(std::exception& e){
+			std::cout << "AuthenticationServer::run(). Exception while loading model " << default_model_dump << "\n";
+			std::cout << e.what() << '\n';
+		}
+	}
+
+	std::cout << "AuthenticationServer: listening on " << this->socket_path_ << std::endl;
+
+	std::vector<std::thread> connections;
+	while(!this->stopped_){
+		int client_socket = accept4(this->listen_socket_, nullptr, nullptr, SOCK_CLOEXEC);
+		if(client_socket < 0){
+			if(errno == EINTR){
+				continue;
+			}
+			break;
+		}
+		connections.emplace_back(&AuthenticationServer::handle_connection, this, client_socket);
+	}
+
+	for(auto& connection : connections){
+		connection.join();
+	}
+
+	close(this->listen_socket_);
+	this->listen_socket_ = -1;
+	unlink(this->socket_path_.c_str());
+}
+
+std::string AuthenticationServer::send_request(const std::string& socket_path, const std::string& request){
+	int client_socket = connect_to(socket_path);
+	if(client_socket < 0){
+		throw std::runtime_error("Server is not running on " + socket_path);
+	}
+
+	std::string message = request + "\n";
+	if(send(client_socket, message.data(), message.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(message.size())){
+		close(client_socket);
+		throw std::runtime_error("Can't send request to server");
+	}
+
+	std::string answer;
+	char chunk[4096];
+	while(answer.find('\n') == std::string::npos){
+		ssize_t bytes_read = recv(client_socket, chunk, sizeof(chunk), 0);
+		if(bytes_read < 0 && errno == EINTR){
+			continue;
+		}
+		if(bytes_read <= 0){
+			break;
+		}
+		answer.append(chunk, bytes_read);
+	}
+	close(client_socket);
+
+	if(answer.find('\n') == std::string::npos){
+		throw std::runtime_error("Server closed connection without answer");
+	}
+	return answer.substr(0, answer.find('\n'));
+}
+
+bool AuthenticationServer::is_running(const std::string& socket_path){
+	int client_socket = connect_to(socket_path);
+	if(client_socket < 0){
+		return false;
+	}
+	close(client_socket);
+	return true;
+}
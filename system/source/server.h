@@ -0,0 +1,159 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "../settings.h"
+#include "features_engine.h"
+#include "features_file.h"
+#include "native_model.h"
+#include "sequential_decision.h"
+#include "util.cpp"
+
+
+class ScorerProcess{
+
+	/*
+	*	Long running python process which classifies features files (run_auth.py serve).
+	*	Models are loaded by it once and stay in memory between requests.
+	*
+	*	Requests and answers are lines written to process stdin and read from its stdout
+	*	(see run_auth.py::serve for format). One request at a time.
+	*	Process is started again if it exited.
+	*/
+
+private:
+
+	pid_t pid_;								// scorer process id (-1 if not running)
+	int to_scorer_;							// scorer stdin
+	int from_scorer_;						// scorer stdout
+	std::string read_buffer_;				// read from stdout but not returned yet
+	std::mutex m_scorer_lock_;				// one request at a time
+
+	void start();
+	void stop();
+
+	// next line from scorer stdout (without '\n')
+	std::string read_line();
+
+	// send request line, return answer (without 'result ' prefix). Throws on 'error ...' answer
+	std::string request(const std::string& request);
+
+
+public:
+
+	ScorerProcess();
+
+	ScorerProcess(const ScorerProcess&) = delete;
+	ScorerProcess& operator=(const ScorerProcess&) = delete;
+
+	~ScorerProcess();
+
+	// load model before first request to it
+	void load_model(const std::string& model_dump_path, const std::string& model_name);
+
+	// class of wav file which features are in given file ('model_dump_path' - trained model dump)
+	int classify(const std::string& features_filepath, const std::string& model_dump_path, const std::string& model_name);
+};
+
+
+class AuthenticationServer{
+
+	/*
+	*	Server mode of authentication system. Listens on local unix socket and answers
+	*	verification requests, so each request does not pay for program start,
+	*	python interpreters start and model loading.
+	*
+	*	Features engine (tables, FFT plans) and models stay in memory, default model
+	*	is loaded at start, others - on first request to them. Models exported in native
+	*	format (see native_model.h) are run in-process, others - by ScorerProcess.
+	*
+	*	Protocol - one line request, one line answer:
+	*	 - "predict <wav_filepath> [<model_folder>]"	-> "ok <class>" or "error <message>"
+	*	   (model folder is server default model folder if not specified)
+	*	 - "stream [<model_folder>]", followed by raw PCM16 samples of voice being recorded
+	*	   (see wav_file.h::PcmStreamFrameReader)		-> "ok <class>" or "error <message>"
+	*	   Answer is sent as soon as class is decided, connection is closed after it.
+	*	   Native models only
+	*	 - "ping"										-> "ok"
+	*	 - "shutdown"									-> "ok" (server stops)
+	*/
+
+private:
+
+	std::string socket_path_;				// unix socket to listen on
+	std::string default_model_folder_;		// model folder used if request does not specify it
+	std::string model_name_;				// one of ['NN', 'RF']
+	FeaturesEngine engine_;					// resident features engine (read-only, shared by connections)
+	DecisionParameters decision_parameters_;	// when class of wav file is decided (native models only, see sequential_decision.h)
+	ScorerProcess scorer_;					// resident python models
+
+	struct LoadedNativeModel{
+		std::time_t modification_time;			// of native model file when it was loaded (model is reloaded if file changed)
+		std::shared_ptr<NativeModel> model;
+	};
+	std::map<std::string, LoadedNativeModel> native_models_;	// model folder -> resident native model
+	std::mutex m_native_models_lock_;
+
+	int listen_socket_;						// listening socket descriptor
+	std::atomic<bool> stopped_;				// shutdown was requested
+	std::atomic<int> requests_counter_;		// to name per-request temporary features files
+
+	// native model from given folder (nullptr if it has no usable native model)
+	std::shared_ptr<NativeModel> get_native_model(const std::string& model_folder);
+
+	// answer for one request line
+	std::string handle_request(const std::string& request);
+
+	// answer for "stream" request: samples are read from client socket ('received_bytes' - samples read with request line)
+	std::string handle_stream(const std::string& request, int client_socket, const std::string& received_bytes);
+
+	// read requests from client and answer them until client disconnects
+	void handle_connection(int client_socket);
+
+	// connected unix socket (or -1 if nobody listens on that path)
+	static int connect_to(const std::string& socket_path);
+
+
+public:
+
+	AuthenticationServer(
+		const std::string& socket_path
+		, const FeaturesParameters& parameters
+		, const std::string& default_model_folder
+		, const std::string& model_name
+		, const DecisionParameters& decision_parameters = DecisionParameters()
+	);
+
+	~AuthenticationServer();
+
+	// listen and answer requests until "shutdown" request
+	void run();
+
+	// client side: send one request and return answer. Throws if server is not running
+	static std::string send_request(const std::string& socket_path, const std::string& request);
+
+	// client side: server is listening on given path
+	static bool is_running(const std::string& socket_path);
+};
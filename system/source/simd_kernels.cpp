@@ -0,0 +1,373 @@
+#include "simd_kernels.h"
+
+
+//----------------------------------------------------------------------------------------------------
+//	Portable kernels
+//----------------------------------------------------------------------------------------------------
+
+
+static void scalar_convert_amplitudes(const short* input, size_t size, double scale, double shift, double* output){
+	for(size_t index = 0; index < size; ++index){
+		output[index] = input[index] * scale + shift;
+	}
+}
+
+static void scalar_preemphasis(const double* input, size_t size, double coefficient, double* output){
+	for(size_t index = 0; index < size; ++index){
+		output[index] = input[index + 1] - coefficient * input[index];
+	}
+}
+
+static void scalar_multiply(const double* input, const double* window, size_t size, double* output){
+	for(size_t index = 0; index < size; ++index){
+		output[index] = input[index] * window[index];
+	}
+}
+
+static void scalar_scale_shift(double* values, size_t size, double scale, double shift){
+	for(size_t index = 0; index < size; ++index){
+		values[index] = values[index] * scale + shift;
+	}
+}
+
+static void scalar_min_max(const double* values, size_t size, double& min_value, double& max_value){
+	for(size_t index = 0; index < size; ++index){
+		min_value = std::min(min_value, values[index]);
+		max_value = std::max(max_value, values[index]);
+	}
+}
+
+static double scalar_sum_of_squares(const double* values, size_t size){
+	double sum = 0.0;
+	for(size_t index = 0; index < size; ++index){
+		sum += values[index] * values[index];
+	}
+	return sum;
+}
+
+static void scalar_multiply_add(const float* input, size_t size, float scale, float* output){
+	for(size_t index = 0; index < size; ++index){
+		output[index] += input[index] * scale;
+	}
+}
+
+
+
+#ifdef VAS_SIMD_X86
+
+//----------------------------------------------------------------------------------------------------
+//	SSE2 kernels (2 doubles per register)
+//----------------------------------------------------------------------------------------------------
+
+
+__attribute__((target("sse2")))
+static void sse2_convert_amplitudes(const short* input, size_t size, double scale, double shift, double* output){
+	__m128d scale_register = _mm_set1_pd(scale);
+	__m128d shift_register = _mm_set1_pd(shift);
+
+	size_t index = 0;
+	for(; index + 8 <= size; index += 8){
+		__m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index));
+
+		// sign extend 16 -> 32 bits
+		__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+		__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+
+		__m128d values[4] = {
+			_mm_cvtepi32_pd(low), _mm_cvtepi32_pd(_mm_shuffle_epi32(low, 0xEE))
+			, _mm_cvtepi32_pd(high), _mm_cvtepi32_pd(_mm_shuffle_epi32(high, 0xEE))
+		};
+
+		for(int part = 0; part < 4; ++part){
+			_mm_storeu_pd(output + index + 2 * part, _mm_add_pd(_mm_mul_pd(values[part], scale_register), shift_register));
+		}
+	}
+
+	scalar_convert_amplitudes(input + index, size - index, scale, shift, output + index);
+}
+
+__attribute__((target("sse2")))
+static void sse2_preemphasis(const double* input, size_t size, double coefficient, double* output){
+	__m128d coefficient_register = _mm_set1_pd(coefficient);
+
+	size_t index = 0;
+	for(; index + 2 <= size; index += 2){
+		__m128d current = _mm_loadu_pd(input + index + 1);
+		__m128d previous = _mm_loadu_pd(input + index);
+		_mm_storeu_pd(output + index, _mm_sub_pd(current, _mm_mul_pd(coefficient_register, previous)));
+	}
+
+	scalar_preemphasis(input + index, size - index, coefficient, output + index);
+}
+
+__attribute__((target("sse2")))
+static void sse2_multiply(const double* input, const double* window, size_t size, double* output){
+	size_t index = 0;
+	for(; index + 2 <= size; index += 2){
+		_mm_storeu_pd(output + index, _mm_mul_pd(_mm_loadu_pd(input + index), _mm_loadu_pd(window + index)));
+	}
+
+	scalar_multiply(input + index, window + index, size - index, output + index);
+}
+
+__attribute__((target("sse2")))
+static void sse2_scale_shift(double* values, size_t size, double scale, double shift){
+	__m128d scale_register = _mm_set1_pd(scale);
+	__m128d shift_register = _mm_set1_pd(shift);
+
+	size_t index = 0;
+	for(; index + 2 <= size; index += 2){
+		_mm_storeu_pd(values + index, _mm_add_pd(_mm_mul_pd(_mm_loadu_pd(values + index), scale_register), shift_register));
+	}
+
+	scalar_scale_shift(values + index, size - index, scale, shift);
+}
+
+__attribute__((target("sse2")))
+static void sse2_min_max(const double* values, size_t size, double& min_value, double& max_value){
+	__m128d min_register = _mm_set1_pd(min_value);
+	__m128d max_register = _mm_set1_pd(max_value);
+
+	size_t index = 0;
+	for(; index + 2 <= size; index += 2){
+		__m128d current = _mm_loadu_pd(values + index);
+		min_register = _mm_min_pd(min_register, current);
+		max_register = _mm_max_pd(max_register, current);
+	}
+
+	double mins[2], maxs[2];
+	_mm_storeu_pd(mins, min_register);
+	_mm_storeu_pd(maxs, max_register);
+	min_value = std::min(mins[0], mins[1]);
+	max_value = std::max(maxs[0], maxs[1]);
+
+	scalar_min_max(values + index, size - index, min_value, max_value);
+}
+
+__attribute__((target("sse2")))
+static double sse2_sum_of_squares(const double* values, size_t size){
+	__m128d sum_register = _mm_setzero_pd();
+
+	size_t index = 0;
+	for(; index + 2 <= size; index += 2){
+		__m128d current = _mm_loadu_pd(values + index);
+		sum_register = _mm_add_pd(sum_register, _mm_mul_pd(current, current));
+	}
+
+	double sums[2];
+	_mm_storeu_pd(sums, sum_register);
+	return sums[0] + sums[1] + scalar_sum_of_squares(values + index, size - index);
+}
+
+__attribute__((target("sse2")))
+static void sse2_multiply_add(const float* input, size_t size, float scale, float* output){
+	__m128 scale_register = _mm_set1_ps(scale);
+
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		__m128 product = _mm_mul_ps(_mm_loadu_ps(input + index), scale_register);
+		_mm_storeu_ps(output + index, _mm_add_ps(_mm_loadu_ps(output + index), product));
+	}
+
+	scalar_multiply_add(input + index, size - index, scale, output + index);
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	AVX2 kernels (4 doubles per register)
+//----------------------------------------------------------------------------------------------------
+
+
+__attribute__((target("avx2")))
+static void avx2_convert_amplitudes(const short* input, size_t size, double scale, double shift, double* output){
+	__m256d scale_register = _mm256_set1_pd(scale);
+	__m256d shift_register = _mm256_set1_pd(shift);
+
+	size_t index = 0;
+	for(; index + 8 <= size; index += 8){
+		__m256i samples = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + index)));
+
+		__m256d low = _mm256_cvtepi32_pd(_mm256_castsi256_si128(samples));
+		__m256d high = _mm256_cvtepi32_pd(_mm256_extracti128_si256(samples, 1));
+
+		_mm256_storeu_pd(output + index, _mm256_add_pd(_mm256_mul_pd(low, scale_register), shift_register));
+		_mm256_storeu_pd(output + index + 4, _mm256_add_pd(_mm256_mul_pd(high, scale_register), shift_register));
+	}
+
+	scalar_convert_amplitudes(input + index, size - index, scale, shift, output + index);
+}
+
+__attribute__((target("avx2")))
+static void avx2_preemphasis(const double* input, size_t size, double coefficient, double* output){
+	__m256d coefficient_register = _mm256_set1_pd(coefficient);
+
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		__m256d current = _mm256_loadu_pd(input + index + 1);
+		__m256d previous = _mm256_loadu_pd(input + index);
+		_mm256_storeu_pd(output + index, _mm256_sub_pd(current, _mm256_mul_pd(coefficient_register, previous)));
+	}
+
+	scalar_preemphasis(input + index, size - index, coefficient, output + index);
+}
+
+__attribute__((target("avx2")))
+static void avx2_multiply(const double* input, const double* window, size_t size, double* output){
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		_mm256_storeu_pd(output + index, _mm256_mul_pd(_mm256_loadu_pd(input + index), _mm256_loadu_pd(window + index)));
+	}
+
+	scalar_multiply(input + index, window + index, size - index, output + index);
+}
+
+__attribute__((target("avx2")))
+static void avx2_scale_shift(double* values, size_t size, double scale, double shift){
+	__m256d scale_register = _mm256_set1_pd(scale);
+	__m256d shift_register = _mm256_set1_pd(shift);
+
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		_mm256_storeu_pd(values + index, _mm256_add_pd(_mm256_mul_pd(_mm256_loadu_pd(values + index), scale_register), shift_register));
+	}
+
+	scalar_scale_shift(values + index, size - index, scale, shift);
+}
+
+__attribute__((target("avx2")))
+static void avx2_min_max(const double* values, size_t size, double& min_value, double& max_value){
+	__m256d min_register = _mm256_set1_pd(min_value);
+	__m256d max_register = _mm256_set1_pd(max_value);
+
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		__m256d current = _mm256_loadu_pd(values + index);
+		min_register = _mm256_min_pd(min_register, current);
+		max_register = _mm256_max_pd(max_register, current);
+	}
+
+	double mins[4], maxs[4];
+	_mm256_storeu_pd(mins, min_register);
+	_mm256_storeu_pd(maxs, max_register);
+	min_value = std::min(std::min(mins[0], mins[1]), std::min(mins[2], mins[3]));
+	max_value = std::max(std::max(maxs[0], maxs[1]), std::max(maxs[2], maxs[3]));
+
+	scalar_min_max(values + index, size - index, min_value, max_value);
+}
+
+__attribute__((target("avx2")))
+static double avx2_sum_of_squares(const double* values, size_t size){
+	__m256d sum_register = _mm256_setzero_pd();
+
+	size_t index = 0;
+	for(; index + 4 <= size; index += 4){
+		__m256d current = _mm256_loadu_pd(values + index);
+		sum_register = _mm256_add_pd(sum_register, _mm256_mul_pd(current, current));
+	}
+
+	double sums[4];
+	_mm256_storeu_pd(sums, sum_register);
+	return (sums[0] + sums[1]) + (sums[2] + sums[3]) + scalar_sum_of_squares(values + index, size - index);
+}
+
+__attribute__((target("avx2")))
+static void avx2_multiply_add(const float* input, size_t size, float scale, float* output){
+	__m256 scale_register = _mm256_set1_ps(scale);
+
+	size_t index = 0;
+	for(; index + 8 <= size; index += 8){
+		__m256 product = _mm256_mul_ps(_mm256_loadu_ps(input + index), scale_register);
+		_mm256_storeu_ps(output + index, _mm256_add_ps(_mm256_loadu_ps(output + index), product));
+	}
+
+	scalar_multiply_add(input + index, size - index, scale, output + index);
+}
+
+#endif
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	Dispatch
+//----------------------------------------------------------------------------------------------------
+
+
+const SimdKernels::KernelsTable& SimdKernels::get_table(){
+	/*
+	*	Selected once (thread-safe static initialization)
+	*/
+
+	static const KernelsTable table = []() -> KernelsTable {
+#ifdef VAS_SIMD_X86
+		if(__builtin_cpu_supports("avx2")){
+			return {SIMD_LEVEL::AVX2, avx2_convert_amplitudes, avx2_preemphasis, avx2_multiply, avx2_scale_shift, avx2_min_max, avx2_sum_of_squares, avx2_multiply_add};
+		}
+		if(__builtin_cpu_supports("sse2")){
+			return {SIMD_LEVEL::SSE2, sse2_convert_amplitudes, sse2_preemphasis, sse2_multiply, sse2_scale_shift, sse2_min_max, sse2_sum_of_squares, sse2_multiply_add};
+		}
+#endif
+		return {SIMD_LEVEL::SCALAR, scalar_convert_amplitudes, scalar_preemphasis, scalar_multiply, scalar_scale_shift, scalar_min_max, scalar_sum_of_squares, scalar_multiply_add};
+	}();
+
+	return table;
+}
+
+SIMD_LEVEL SimdKernels::get_level(){
+	return get_table().level;
+}
+
+void SimdKernels::convert_amplitudes(const short* input, size_t size, double scale, double shift, double* output){
+	get_table().convert_amplitudes(input, size, scale, shift, output);
+}
+
+void SimdKernels::preemphasis(const double* input, size_t size, double coefficient, double* output){
+	get_table().preemphasis(input, size, coefficient, output);
+}
+
+void SimdKernels::multiply(const double* input, const double* window, size_t size, double* output){
+	get_table().multiply(input, window, size, output);
+}
+
+void SimdKernels::multiply_add(const float* input, size_t size, float scale, float* output){
+	get_table().multiply_add(input, size, scale, output);
+}
+
+void SimdKernels::normalize_peak(double* values, size_t size){
+	if(size == 0){
+		return;
+	}
+
+	double min_value = values[0], max_value = values[0];
+	get_table().min_max(values, size, min_value, max_value);
+
+	double peak = std::max(std::fabs(min_value), std::fabs(max_value));
+	if(peak > 0.0){
+		get_table().scale_shift(values, size, 1.0 / peak, 0.0);
+	}
+}
+
+void SimdKernels::normalize_rms(double* values, size_t size){
+	if(size == 0){
+		return;
+	}
+
+	double rms = std::sqrt(get_table().sum_of_squares(values, size) / size);
+	if(rms > 0.0){
+		get_table().scale_shift(values, size, 1.0 / rms, 0.0);
+	}
+}
+
+void SimdKernels::normalize_max_min(double* values, size_t size){
+	if(size == 0){
+		return;
+	}
+
+	double min_value = values[0], max_value = values[0];
+	get_table().min_max(values, size, min_value, max_value);
+
+	if(max_value > min_value){
+		double scale = 1.0 / (max_value - min_value);
+		get_table().scale_shift(values, size, scale, -min_value * scale);
+	}
+}
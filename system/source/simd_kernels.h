@@ -0,0 +1,71 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define VAS_SIMD_X86
+#include <immintrin.h>
+#endif
+
+
+enum class SIMD_LEVEL : int {
+	SCALAR, SSE2, AVX2
+};
+
+
+class SimdKernels{
+
+	/*
+	*	Innermost per-sample loops of features extraction: amplitudes conversion
+	*	(int16 -> double), preemphasis, window multiplication and amplitudes normalization
+	*	(peak, rms, max-min). And innermost loop of dense layers (see dense_network.h).
+	*
+	*	Each kernel has AVX2, SSE2 and portable versions. Best version supported by
+	*	current CPU is selected once at runtime (so one binary works on any x86 host),
+	*	all versions give the same results as plain loops (no FMA contraction).
+	*/
+
+private:
+
+	struct KernelsTable{
+		SIMD_LEVEL level;
+		void (*convert_amplitudes)(const short* input, size_t size, double scale, double shift, double* output);
+		void (*preemphasis)(const double* input, size_t size, double coefficient, double* output);
+		void (*multiply)(const double* input, const double* window, size_t size, double* output);
+		void (*scale_shift)(double* values, size_t size, double scale, double shift);
+		void (*min_max)(const double* values, size_t size, double& min_value, double& max_value);
+		double (*sum_of_squares)(const double* values, size_t size);
+		void (*multiply_add)(const float* input, size_t size, float scale, float* output);
+	};
+
+	// kernels for current CPU (selected on first call)
+	static const KernelsTable& get_table();
+
+
+public:
+
+	static SIMD_LEVEL get_level();
+
+	// output[i] = input[i] * scale + shift
+	static void convert_amplitudes(const short* input, size_t size, double scale, double shift, double* output);
+
+	// output[i] = input[i + 1] - coefficient * input[i], i < size (input has size + 1 values, output != input)
+	static void preemphasis(const double* input, size_t size, double coefficient, double* output);
+
+	// output[i] = input[i] * window[i]
+	static void multiply(const double* input, const double* window, size_t size, double* output);
+
+	// output[i] += input[i] * scale
+	static void multiply_add(const float* input, size_t size, float scale, float* output);
+
+	// values / max(|values|)
+	static void normalize_peak(double* values, size_t size);
+
+	// values / sqrt(mean(values^2))
+	static void normalize_rms(double* values, size_t size);
+
+	// (values - min) / (max - min)
+	static void normalize_max_min(double* values, size_t size);
+};
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cmath>
 #include <vector>
 #include <boost/filesystem.hpp>
 #include <boost/format.hpp>
@@ -70,6 +71,19 @@ bool check_wav_file_format(const WavHeader& wav_header){
 }
 
 
+int count_frames(long long number_of_samples, int frame_length, int frame_step){
+	/*
+	*	Number of frames in signal of given length (python_speech_features.sigproc.framesig).
+	*	Last frame is zero padded, so there is always at least one frame.
+	*/
+
+	if(number_of_samples <= frame_length){
+		return 1;
+	}
+	return 1 + static_cast<int>(std::ceil(double(number_of_samples - frame_length) / frame_step));
+}
+
+
 std::string generate_features_output_filepath(const std::string& input_wav_filepath){
 	/*
 	*	With given wav file from train or test folder generate filepath to store features to. 
@@ -1,4 +1,5 @@
 #include "wav_file.h"
+#include "util.cpp"
 
 
 //----------------------------------------------------------------------------------------------------
@@ -72,6 +73,30 @@ void WavHeader::print(){
 
 
 
+//----------------------------------------------------------------------------------------------------
+//	Amplitudes View
+//----------------------------------------------------------------------------------------------------
+
+
+AmplitudesView::AmplitudesView(const short* set_data, size_t set_size)
+	: data(set_data)
+	, size(set_size)
+{ }
+
+const short* AmplitudesView::begin() const{
+	return this->data;
+}
+
+const short* AmplitudesView::end() const{
+	return this->data + this->size;
+}
+
+short AmplitudesView::operator[](size_t index) const{
+	return this->data[index];
+}
+
+
+
 //----------------------------------------------------------------------------------------------------
 //	Wav File
 //----------------------------------------------------------------------------------------------------
@@ -81,15 +106,34 @@ void WavHeader::print(){
 *	Constructors (+ operator=)
 */
 
-WavFile::WavFile() {
+WavFile::WavFile()
+	: mapped_file(nullptr)
+	, mapped_size(0)
+	, mapped_data(nullptr)
+{
 	this->data = new char[42];
 }
 
-WavFile::WavFile(const std::string& filename){
-	this->init(filename);
+WavFile::WavFile(const std::string& filename, bool memory_mapped)
+	: data(nullptr)
+	, mapped_file(nullptr)
+	, mapped_size(0)
+	, mapped_data(nullptr)
+{
+	if(memory_mapped){
+		this->map_file(filename);
+	}
+	else{
+		this->init(filename);
+	}
 }
 
-WavFile::WavFile(const WavFile& another_file){
+WavFile::WavFile(const WavFile& another_file)
+	: data(nullptr)
+	, mapped_file(nullptr)
+	, mapped_size(0)
+	, mapped_data(nullptr)
+{
 	this->clone_file(another_file);
 }
 
@@ -111,8 +155,19 @@ WavFile& WavFile::operator=(const WavFile& another_file){
 *	Main interface
 */
 
-void WavFile::load(const std::string& filepath){
-	this->init(filepath);
+void WavFile::load(const std::string& filepath, bool memory_mapped){
+	this->delete_file();
+
+	if(memory_mapped){
+		this->map_file(filepath);
+	}
+	else{
+		this->init(filepath);
+	}
+}
+
+bool WavFile::is_memory_mapped() const{
+	return this->mapped_file != nullptr;
 }
 
 int WavFile::get_size_in_bytes(){
@@ -131,15 +186,12 @@ std::vector<short> WavFile::get_amplitudes(){
 
 	try{
 		// raw parse is good here
-		short* new_data = reinterpret_cast<short *>(data);
-		
-		// 16 bit = 2 bytes
-		int number_of_samples = wav_header.subchunk2_size / 2;
+		AmplitudesView view = this->get_amplitudes_view();
 		
 		// convert to vector
 		std::vector<short> amplitudes;
-		amplitudes.reserve(number_of_samples);
-		std::move(new_data, new_data + number_of_samples, std::back_inserter(amplitudes));
+		amplitudes.reserve(view.size);
+		std::move(view.begin(), view.end(), std::back_inserter(amplitudes));
 
 		return amplitudes;
 	}
@@ -150,6 +202,16 @@ std::vector<short> WavFile::get_amplitudes(){
 }
 
 
+AmplitudesView WavFile::get_amplitudes_view() const{
+	/*
+	*	View over amplitudes in this->data or in mapped file (16 bit = 2 bytes per sample)
+	*/
+
+	const char* samples = this->is_memory_mapped() ? this->mapped_data : this->data;
+	return AmplitudesView(reinterpret_cast<const short *>(samples), wav_header.subchunk2_size / 2);
+}
+
+
 void WavFile::write_amplitudes(const std::string& destination_file){
 	/*
 	*	Writing wav file amplitudes to specified wav file separating amplitudes with spaces. 
@@ -171,27 +233,174 @@ void WavFile::write_amplitudes(const std::string& destination_file){
 }
 
 
+void WavFile::save_samples(const std::string& filepath, const short* samples, size_t number_of_samples, int sample_rate){
+	uint32_t data_size = number_of_samples * sizeof(short);
+	WavHeader header(
+		0x46464952						// 'RIFF'
+		, 36 + data_size
+		, 0x45564157					// 'WAVE'
+		, 0x20746d66					// 'fmt '
+		, 16
+		, 1								// PCM
+		, 1								// mono
+		, sample_rate
+		, sample_rate * 2
+		, 2
+		, 16
+		, 0x61746164					// 'data'
+		, data_size
+	);
+
+	std::ofstream outf(filepath, std::ios::binary);
+	const int int_fields[] = {header.chunk_ID, header.chunk_size, header.format, header.subchunk1_ID, header.subchunk1_Size};
+	const short short_fields[] = {header.audio_format, header.num_channels};
+	const int rate_fields[] = {header.sample_rate, header.byte_rate};
+	const short block_fields[] = {header.block_align, header.bits_per_sample};
+	const int data_fields[] = {header.subchunk2_ID, header.subchunk2_size};
+
+	outf.write(reinterpret_cast<const char*>(int_fields), sizeof(int_fields));
+	outf.write(reinterpret_cast<const char*>(short_fields), sizeof(short_fields));
+	outf.write(reinterpret_cast<const char*>(rate_fields), sizeof(rate_fields));
+	outf.write(reinterpret_cast<const char*>(block_fields), sizeof(block_fields));
+	outf.write(reinterpret_cast<const char*>(data_fields), sizeof(data_fields));
+	outf.write(reinterpret_cast<const char*>(samples), data_size);
+
+	if(!outf){
+		std::cout << "WavFile::save_samples(...). Can't write file " << filepath << "\n";
+		throw std::runtime_error("Can't write file " + filepath);
+	}
+}
+
+
 /*
 *	Secondary functions for managing WavFile work and processing.
 */
 
+size_t WavFile::parse_chunks(const std::function<size_t(size_t, size_t, char*)>& read_bytes, size_t file_size, const std::string& filename, WavHeader& header){
+	/*
+	*	Walk RIFF chunks one by one instead of reading fixed 44-byte header, so files
+	*	with LIST / fact / any other chunks (at any offset) and WAVE_FORMAT_EXTENSIBLE
+	*	'fmt ' chunks are parsed correctly. Unknown chunks are skipped.
+	*
+	*	'read_bytes(offset, size, destination)' reads file bytes and returns number of bytes read.
+	*	Found format is validated with check_wav_file_format(...) (see util.cpp).
+	*/
+
+	const unsigned short FORMAT_PCM = 1;
+	const unsigned short FORMAT_EXTENSIBLE = 0xFFFE;
+
+	char riff_header[12];
+	if(read_bytes(0, sizeof(riff_header), riff_header) != sizeof(riff_header)
+		|| std::memcmp(riff_header, "RIFF", 4) != 0
+		|| std::memcmp(riff_header + 8, "WAVE", 4) != 0)
+	{
+		std::cout << "WavFile::parse_chunks(). Not a RIFF/WAVE file: " + filename << "\n";
+		throw std::runtime_error("Not a RIFF/WAVE file: " + filename);
+	}
+
+	std::memcpy(&header.chunk_ID, riff_header, 4);
+	std::memcpy(&header.chunk_size, riff_header + 4, 4);
+	std::memcpy(&header.format, riff_header + 8, 4);
+
+	bool fmt_found = false, data_found = false;
+	size_t data_offset = 0;
+	size_t chunk_offset = sizeof(riff_header);
+
+	while(chunk_offset + 8 <= file_size && !(fmt_found && data_found)){
+		char chunk_header[8];
+		if(read_bytes(chunk_offset, sizeof(chunk_header), chunk_header) != sizeof(chunk_header)){
+			break;
+		}
+
+		unsigned int chunk_size;
+		std::memcpy(&chunk_size, chunk_header + 4, 4);
+		size_t chunk_data_offset = chunk_offset + 8;
+
+		if(std::memcmp(chunk_header, "fmt ", 4) == 0){
+			// PCM fmt is 16 bytes, extensible - 40 bytes (sub format GUID starts at 24)
+			char fmt[40] = {0};
+			size_t fmt_size = read_bytes(chunk_data_offset, std::min<size_t>(chunk_size, sizeof(fmt)), fmt);
+			if(fmt_size < 16){
+				break;
+			}
+
+			std::memcpy(&header.subchunk1_ID, chunk_header, 4);
+			header.subchunk1_Size = chunk_size;
+			std::memcpy(&header.audio_format, fmt, 2);
+			std::memcpy(&header.num_channels, fmt + 2, 2);
+			std::memcpy(&header.sample_rate, fmt + 4, 4);
+			std::memcpy(&header.byte_rate, fmt + 8, 4);
+			std::memcpy(&header.block_align, fmt + 12, 2);
+			std::memcpy(&header.bits_per_sample, fmt + 14, 2);
+
+			// real format of extensible file is in first two bytes of sub format GUID
+			if(static_cast<unsigned short>(header.audio_format) == FORMAT_EXTENSIBLE && fmt_size >= 26){
+				std::memcpy(&header.audio_format, fmt + 24, 2);
+			}
+
+			fmt_found = true;
+		}
+		else if(std::memcmp(chunk_header, "data", 4) == 0){
+			std::memcpy(&header.subchunk2_ID, chunk_header, 4);
+
+			// do not trust data size if file is truncated (or size is unknown, e.g. 0xFFFFFFFF while streaming)
+			size_t available_bytes = file_size - chunk_data_offset;
+			header.subchunk2_size = static_cast<int>(std::min<size_t>(chunk_size, available_bytes));
+
+			data_offset = chunk_data_offset;
+			data_found = true;
+		}
+
+		// chunks are word aligned
+		chunk_offset = chunk_data_offset + chunk_size + (chunk_size & 1);
+	}
+
+	if(!fmt_found || !data_found){
+		std::cout << "WavFile::parse_chunks(). No 'fmt ' or 'data' chunk in file: " + filename << "\n";
+		throw std::runtime_error("No 'fmt ' or 'data' chunk in file: " + filename);
+	}
+
+	if(static_cast<unsigned short>(header.audio_format) != FORMAT_PCM || !check_wav_file_format(header)){
+		std::cout << "WavFile::parse_chunks(). Unsupported wav file format: " + filename << "\n";
+		header.print();
+		throw std::runtime_error("Unsupported wav file format: " + filename);
+	}
+
+	return data_offset;
+}
+
 void WavFile::init(const std::string& filename){
 	/*
 	*	Initializing class instance data (WavHeader and char *data).
-	*	Read wav file as binary file (WavHeader::HEADER_SIZE for header data,
-	*	rest is for this->data)
+	*	Read wav file as binary file: walk chunks to find header data (see parse_chunks(...)),
+	*	then read 'data' chunk into this->data
 	*/
 
 	try {
 		std::fstream inf(filename, std::fstream::in | std::fstream::binary);
 		if(inf.is_open()){
+			inf.seekg(0, inf.end);
+			size_t file_size = inf.tellg();
+
 			// initialize this->header
-			inf.read((char*)&(this->wav_header), sizeof(this->wav_header));
+			size_t data_offset = this->parse_chunks(
+				[&inf](size_t offset, size_t size, char* destination) -> size_t {
+					inf.clear();
+					inf.seekg(offset);
+					inf.read(destination, size);
+					return inf.gcount();
+				}
+				, file_size
+				, filename
+				, this->wav_header
+			);
 			
 			// from this->header find out data size in bytes
 			data = new char[(this->wav_header).subchunk2_size];
 
 			// read the rest of wav file data into this->data
+			inf.clear();
+			inf.seekg(data_offset);
 			inf.read(data, (this->wav_header).subchunk2_size);
 			inf.close();	
 		}
@@ -206,16 +415,304 @@ void WavFile::init(const std::string& filename){
 	}
 }
 
+void WavFile::map_file(const std::string& filename){
+	/*
+	*	Memory mapped alternative of init(...). Header is parsed right from mapped
+	*	region, this->data is not allocated: amplitudes are read from mapping.
+	*/
+
+	int file_descriptor = open(filename.c_str(), O_RDONLY);
+	if(file_descriptor < 0){
+		std::cout << "Can't open file: " + filename << "\n";
+		throw std::runtime_error("Can't open file: " + filename);
+	}
+
+	struct stat file_info;
+	if(fstat(file_descriptor, &file_info) != 0 || file_info.st_size < 12){
+		close(file_descriptor);
+		std::cout << "WavFile::map_file(). File is too small to be wav file: " + filename << "\n";
+		throw std::runtime_error("File is too small to be wav file: " + filename);
+	}
+
+	void* region = mmap(nullptr, file_info.st_size, PROT_READ, MAP_PRIVATE, file_descriptor, 0);
+	close(file_descriptor);
+
+	if(region == MAP_FAILED){
+		std::cout << "WavFile::map_file(). Can't map file: " + filename << "\n";
+		throw std::runtime_error("Can't map file: " + filename);
+	}
+
+	// samples are read front to back
+	madvise(region, file_info.st_size, MADV_SEQUENTIAL);
+
+	this->mapped_file = static_cast<char*>(region);
+	this->mapped_size = file_info.st_size;
+
+	const char* mapped_file = this->mapped_file;
+	size_t mapped_size = this->mapped_size;
+
+	try{
+		size_t data_offset = this->parse_chunks(
+			[mapped_file, mapped_size](size_t offset, size_t size, char* destination) -> size_t {
+				size_t available = offset < mapped_size ? std::min(size, mapped_size - offset) : 0;
+				std::memcpy(destination, mapped_file + offset, available);
+				return available;
+			}
+			, mapped_size
+			, filename
+			, this->wav_header
+		);
+		this->mapped_data = this->mapped_file + data_offset;
+	}
+	catch(std::exception& e){
+		this->delete_file();
+		throw;
+	}
+}
+
 void WavFile::delete_file(){
 	delete[] this->data;
+	this->data = nullptr;
+
+	if(this->mapped_file != nullptr){
+		munmap(this->mapped_file, this->mapped_size);
+		this->mapped_file = nullptr;
+		this->mapped_size = 0;
+		this->mapped_data = nullptr;
+	}
 }
 
 void WavFile::clone_file(const WavFile& another_file){
-	this->wav_header = another_file.wav_header;
+	/*
+	*	Clone of memory mapped file is a regular (in memory) file
+	*/
+
 	this->delete_file();
+	this->wav_header = another_file.wav_header;
 	this->data = new char[another_file.wav_header.subchunk2_size];
 
+	const char* another_data = another_file.is_memory_mapped() ? another_file.mapped_data : another_file.data;
 	for(size_t byte = 0; byte < another_file.wav_header.subchunk2_size; ++byte){
-		this->data[byte] = another_file.data[byte];
+		this->data[byte] = another_data[byte];
+	}
+}
+
+
+//----------------------------------------------------------------------------------------------------
+//	Wav Frame Reader
+//----------------------------------------------------------------------------------------------------
+
+
+WavFrameReader::WavFrameReader(const std::string& filepath, int frame_length, int frame_step, int read_chunk_samples)
+	: input_(filepath, std::ifstream::in | std::ifstream::binary)
+	, frame_length_(frame_length)
+	, frame_step_(frame_step)
+	, next_frame_index_(0)
+	, ring_(frame_length + 1, 0)
+	, stream_position_(0)
+	, read_buffer_(read_chunk_samples)
+{
+	if(!this->input_.is_open()){
+		std::cout << "Can't open file: " + filepath << "\n";
+		throw std::runtime_error("Can't open file: " + filepath);
 	}
-}
\ No newline at end of file
+
+	this->input_.seekg(0, this->input_.end);
+	size_t file_size = this->input_.tellg();
+
+	std::ifstream& input = this->input_;
+	this->data_offset_ = WavFile::parse_chunks(
+		[&input](size_t offset, size_t size, char* destination) -> size_t {
+			input.clear();
+			input.seekg(offset);
+			input.read(destination, size);
+			return input.gcount();
+		}
+		, file_size
+		, filepath
+		, this->wav_header_
+	);
+
+	// 16 bit = 2 bytes
+	this->number_of_samples_ = this->wav_header_.subchunk2_size / 2;
+	this->number_of_frames_ = count_frames(this->number_of_samples_, frame_length, frame_step);
+
+	this->input_.clear();
+	this->input_.seekg(this->data_offset_);
+}
+
+WavHeader WavFrameReader::get_header() const{
+	return this->wav_header_;
+}
+
+long long WavFrameReader::get_number_of_samples() const{
+	return this->number_of_samples_;
+}
+
+int WavFrameReader::get_number_of_frames() const{
+	return this->number_of_frames_;
+}
+
+void WavFrameReader::fill_until(long long end_position){
+	end_position = std::min(end_position, this->number_of_samples_);
+	long long ring_size = this->ring_.size();
+
+	// samples which will be overwritten in ring before being used - skip them
+	if(end_position - this->stream_position_ > ring_size){
+		this->stream_position_ = end_position - ring_size;
+		this->input_.seekg(this->data_offset_ + this->stream_position_ * 2);
+	}
+
+	while(this->stream_position_ < end_position){
+		long long chunk_samples = std::min<long long>(this->read_buffer_.size(), end_position - this->stream_position_);
+		this->input_.read(reinterpret_cast<char*>(this->read_buffer_.data()), chunk_samples * 2);
+
+		long long samples_read = this->input_.gcount() / 2;
+		if(samples_read <= 0){
+			// file is shorter than header says - rest of samples are zeros
+			std::fill(this->read_buffer_.begin(), this->read_buffer_.begin() + chunk_samples, 0);
+			samples_read = chunk_samples;
+		}
+
+		for(long long index = 0; index < samples_read; ++index){
+			this->ring_[(this->stream_position_ + index) % ring_size] = this->read_buffer_[index];
+		}
+		this->stream_position_ += samples_read;
+	}
+}
+
+bool WavFrameReader::next_frame(FrameSamples& frame){
+	if(this->next_frame_index_ >= this->number_of_frames_){
+		return false;
+	}
+
+	long long ring_size = this->ring_.size();
+	long long frame_start = static_cast<long long>(this->next_frame_index_) * this->frame_step_;
+	++this->next_frame_index_;
+
+	this->fill_until(frame_start + this->frame_length_);
+
+	frame.samples.assign(this->frame_length_, 0);
+	frame.valid_samples = static_cast<int>(std::max(0LL, std::min<long long>(this->frame_length_, this->number_of_samples_ - frame_start)));
+	frame.has_previous = frame_start > 0 && frame_start <= this->number_of_samples_;
+	frame.previous_sample = frame.has_previous ? this->ring_[(frame_start - 1) % ring_size] : 0;
+
+	for(int index = 0; index < frame.valid_samples; ++index){
+		frame.samples[index] = this->ring_[(frame_start + index) % ring_size];
+	}
+
+	return true;
+}
+
+
+
+//----------------------------------------------------------------------------------------------------
+//	PCM Stream Frame Reader
+//----------------------------------------------------------------------------------------------------
+
+
+const int PcmStreamFrameReader::READ_CHUNK_BYTES = 8192;
+
+
+PcmStreamFrameReader::PcmStreamFrameReader(
+	int file_descriptor
+	, int frame_length
+	, int frame_step
+	, long long max_samples
+	, const std::string& received_bytes
+	, std::vector<short>* recording
+)
+	: file_descriptor_(file_descriptor)
+	, frame_length_(frame_length)
+	, frame_step_(frame_step)
+	, max_samples_(max_samples)
+	, next_frame_index_(0)
+	, buffer_start_(0)
+	, number_of_samples_(0)
+	, stream_ended_(false)
+	, pending_bytes_(received_bytes)
+	, recording_(recording)
+{
+	this->parse_pending_bytes();
+}
+
+void PcmStreamFrameReader::parse_pending_bytes(){
+	size_t number_of_new_samples = this->pending_bytes_.size() / 2;
+	if(this->max_samples_ > 0){
+		number_of_new_samples = std::min<long long>(number_of_new_samples, this->max_samples_ - this->number_of_samples_);
+	}
+
+	size_t old_size = this->buffer_.size();
+	this->buffer_.resize(old_size + number_of_new_samples);
+	std::memcpy(this->buffer_.data() + old_size, this->pending_bytes_.data(), number_of_new_samples * 2);
+
+	if(this->recording_ != nullptr){
+		this->recording_->insert(this->recording_->end(), this->buffer_.begin() + old_size, this->buffer_.end());
+	}
+
+	this->pending_bytes_.erase(0, number_of_new_samples * 2);
+	this->number_of_samples_ += number_of_new_samples;
+
+	if(this->max_samples_ > 0 && this->number_of_samples_ >= this->max_samples_){
+		this->stream_ended_ = true;
+	}
+}
+
+bool PcmStreamFrameReader::read_chunk(){
+	if(this->stream_ended_){
+		return false;
+	}
+
+	char chunk[READ_CHUNK_BYTES];
+	ssize_t bytes_read;
+	do{
+		bytes_read = read(this->file_descriptor_, chunk, sizeof(chunk));
+	} while(bytes_read < 0 && errno == EINTR);
+
+	if(bytes_read <= 0){
+		this->stream_ended_ = true;
+		return false;
+	}
+
+	this->pending_bytes_.append(chunk, bytes_read);
+	this->parse_pending_bytes();
+	return true;
+}
+
+long long PcmStreamFrameReader::get_number_of_samples() const{
+	return this->number_of_samples_;
+}
+
+bool PcmStreamFrameReader::next_frame(FrameSamples& frame){
+	long long frame_start = static_cast<long long>(this->next_frame_index_) * this->frame_step_;
+
+	// wait for whole frame (or end of stream)
+	while(this->number_of_samples_ < frame_start + this->frame_length_ && this->read_chunk());
+
+	// after end of stream number of frames is known (see util.cpp::count_frames)
+	if(this->stream_ended_ && this->next_frame_index_ >= count_frames(this->number_of_samples_, this->frame_length_, this->frame_step_)){
+		return false;
+	}
+	++this->next_frame_index_;
+
+	frame.samples.assign(this->frame_length_, 0);
+	frame.valid_samples = static_cast<int>(std::max(0LL, std::min<long long>(this->frame_length_, this->number_of_samples_ - frame_start)));
+	frame.has_previous = frame_start > 0 && frame_start <= this->number_of_samples_;
+	frame.previous_sample = frame.has_previous ? this->buffer_[frame_start - 1 - this->buffer_start_] : 0;
+
+	std::copy(
+		this->buffer_.begin() + (frame_start - this->buffer_start_)
+		, this->buffer_.begin() + (frame_start - this->buffer_start_ + frame.valid_samples)
+		, frame.samples.begin()
+	);
+
+	// samples before next frame (and its previous sample) are not needed anymore
+	long long next_frame_start = frame_start + this->frame_step_;
+	long long not_needed = std::min<long long>(next_frame_start - 1, this->number_of_samples_) - this->buffer_start_;
+	if(not_needed > 0 && not_needed * 2 >= static_cast<long long>(this->buffer_.size())){
+		this->buffer_.erase(this->buffer_.begin(), this->buffer_.begin() + not_needed);
+		this->buffer_start_ += not_needed;
+	}
+
+	return true;
+}
@@ -1,9 +1,20 @@
 #pragma once
 
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <string>
 #include <vector>
 #include <fstream>
+#include <functional>
+#include <cstring>
 #include <iterator>
 #include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 
 struct WavHeader{
@@ -53,17 +64,45 @@ public:
 };
 
 
+struct AmplitudesView{
+
+	/*
+	*	Read-only view over wav file amplitudes (16-bit samples). Nothing is copied:
+	*	view points into WavFile data, so it is valid only while that WavFile is alive.
+	*/
+
+	const short* data;						// first sample
+	size_t size;							// number of samples
+
+
+public:
+
+	AmplitudesView(const short* set_data = nullptr, size_t set_size = 0);
+
+	const short* begin() const;
+	const short* end() const;
+	short operator[](size_t index) const;
+};
+
+
 class WavFile {
 
 	/*
 	*	Class to work with wav files. Methods implements only routine
 	*	which was needed for VAS correct work. 
+	*
+	*	In memory mapped mode file is not read at all: it is mapped read-only into memory
+	*	and amplitudes are available through get_amplitudes_view() without any copy or
+	*	allocation. OS pages data in lazily, so even hour-long recordings are cheap to open.
 	*/
 
 private:
 
 	WavHeader wav_header;	// header data is stored here
-	char* data;				// main wav file data is stored here
+	char* data;				// main wav file data is stored here (nullptr in memory mapped mode)
+	char* mapped_file;		// whole file mapped into memory (nullptr if not in memory mapped mode)
+	size_t mapped_size;		// size of mapped region in bytes
+	const char* mapped_data;	// start of wav data inside mapped region
 
 
 protected:
@@ -71,6 +110,9 @@ protected:
 	// initialize this->data with wav file data (raw bytes)
 	void init(const std::string& filename);
 
+	// map wav file into memory (read-only) and point this->mapped_data to its data
+	void map_file(const std::string& filename);
+
 	// deletes data (this->data)
 	void delete_file();
 
@@ -87,8 +129,8 @@ public:
 	// default constructor
 	WavFile();
 
-	// initialize data from wav file specified by filepath
-	WavFile(const std::string& filepath);
+	// initialize data from wav file specified by filepath (read or memory map it)
+	WavFile(const std::string& filepath, bool memory_mapped = false);
 
 	// copy constructor
 	WavFile(const WavFile& another_file);
@@ -104,8 +146,11 @@ public:
 	*	Main interface
 	*/
 
-	// loads data from file (header and this->data)
-	void load(const std::string& filename);
+	// loads data from file (header and this->data) or maps it into memory
+	void load(const std::string& filename, bool memory_mapped = false);
+
+	// is file opened in memory mapped mode
+	bool is_memory_mapped() const;
 
 	// returns loaded wav file header
 	WavHeader get_header();
@@ -116,7 +161,133 @@ public:
 	// get wav file amplitudes (for now we can do that only for 16-bit)
 	std::vector<short> get_amplitudes();
 
+	// same amplitudes without copying (valid while this object is alive)
+	AmplitudesView get_amplitudes_view() const;
+
 	// write extracted amplitudes to specified file
 	void write_amplitudes(const std::string& destination_file);
 
+	// save samples as wav file in system format (16 bit, mono)
+	static void save_samples(const std::string& filepath, const short* samples, size_t number_of_samples, int sample_rate);
+
+	// walk RIFF chunks, fill header from 'fmt ' and 'data' chunks, return offset of data
+	static size_t parse_chunks(const std::function<size_t(size_t, size_t, char*)>& read_bytes, size_t file_size, const std::string& filename, WavHeader& header);
+
+};
+
+
+struct FrameSamples{
+
+	/*
+	*	One frame produced by WavFrameReader.
+	*/
+
+	std::vector<short> samples;				// frame samples (zero padded after valid_samples)
+	int valid_samples;						// number of real (not padding) samples in frame
+	bool has_previous;						// false only for the frame starting at the first sample
+	short previous_sample;					// sample right before frame (needed for preemphasis)
+};
+
+
+class WavFrameReader{
+
+	/*
+	*	Streaming frames source over wav file. Frames have length 'frame_length' and start
+	*	every 'frame_step' samples (same framing as features extraction, see util.cpp::count_frames).
+	*
+	*	File is read from disk in chunks of 'read_chunk_samples' samples into ring buffer of
+	*	frame_length + 1 samples (frame plus one previous sample), overlapping frames are
+	*	copied out from that ring. So memory used does not depend on recording length.
+	*	Samples between frames (when step is longer than frame) are skipped without reading.
+	*/
+
+private:
+
+	std::ifstream input_;					// opened wav file
+	WavHeader wav_header_;					// parsed wav header (see WavFile::parse_chunks)
+	size_t data_offset_;					// offset of first sample in file (bytes)
+	long long number_of_samples_;			// total number of samples in file
+
+	int frame_length_;						// frame length (samples)
+	int frame_step_;						// step between frames (samples)
+	int number_of_frames_;					// total number of frames
+	int next_frame_index_;					// index of frame to read next
+
+	std::vector<short> ring_;				// last frame_length + 1 samples, sample i stored at i % ring size
+	long long stream_position_;				// number of samples consumed from file (next sample to read)
+	std::vector<short> read_buffer_;		// chunk read from disk
+
+
+	// read samples from file until sample with given index (exclusive) is in ring
+	void fill_until(long long end_position);
+
+
+public:
+
+	WavFrameReader(const std::string& filepath, int frame_length, int frame_step, int read_chunk_samples = 16384);
+
+	WavHeader get_header() const;
+
+	long long get_number_of_samples() const;
+
+	int get_number_of_frames() const;
+
+	// read next frame. Returns false if there are no more frames
+	bool next_frame(FrameSamples& frame);
+};
+
+
+class PcmStreamFrameReader{
+
+	/*
+	*	Streaming frames source over raw audio coming from pipe or socket: 16 bit little endian
+	*	mono samples (system wav files samples, without header), e.g. from microphone.
+	*
+	*	Gives the same frames as WavFrameReader gives for wav file with the same samples.
+	*	Frame is returned as soon as all its samples arrived (read blocks until then), so frames
+	*	are extracted while audio is still being captured. Last (zero padded) frames are returned
+	*	when stream ends. Only samples of not yet returned frames are kept in memory.
+	*/
+
+private:
+
+	static const int READ_CHUNK_BYTES;
+
+	int file_descriptor_;					// pipe or socket to read samples from
+	int frame_length_;						// frame length (samples)
+	int frame_step_;						// step between frames (samples)
+	long long max_samples_;					// stream is considered ended after that many samples (0 - no limit)
+	int next_frame_index_;					// index of frame to return next
+
+	std::vector<short> buffer_;				// received samples starting from buffer_start_
+	long long buffer_start_;				// index (in stream) of first sample in buffer_
+	long long number_of_samples_;			// samples received so far
+	bool stream_ended_;
+	std::string pending_bytes_;				// received bytes which are not whole sample yet (or not parsed yet)
+	std::vector<short>* recording_;			// all received samples are also appended here (if not nullptr)
+
+	// wait for next chunk of samples. Returns false if stream ended
+	bool read_chunk();
+
+	// move received bytes into buffer_ as samples
+	void parse_pending_bytes();
+
+
+public:
+
+	// 'received_bytes' - beginning of stream which was already read from descriptor
+	PcmStreamFrameReader(
+		int file_descriptor
+		, int frame_length
+		, int frame_step
+		, long long max_samples = 0
+		, const std::string& received_bytes = ""
+		, std::vector<short>* recording = nullptr
+	);
+
+	// samples received so far
+	long long get_number_of_samples() const;
+
+	// read next frame. Returns false if stream ended and there are no more frames
+	bool next_frame(FrameSamples& frame);
 };
@@ -36,6 +36,35 @@ class Recorder:
         print 'Done recording.'
         return frames
 
+    def stream(self, output, seconds=5):
+        """
+        Write samples to output (raw 16 bit little endian) while recording, chunk by chunk,
+        so they can be processed before recording ends (see 'listen' mode of system/executable).
+
+        :param output: file-like object (e.g. stdout piped into system/executable)
+        :param seconds: max recording length. Recording stops earlier if output is closed
+        """
+        audio_stream = self.listener.open(
+            format=self.format, channels=self.channels,
+            rate=self.rate, input=True, frames_per_buffer=self.chunk
+        )
+
+        for i in range(0, int(self.rate / self.chunk * seconds)):
+            amplitude_values = array('h', audio_stream.read(self.chunk))
+            if byteorder == 'big':
+                amplitude_values.byteswap()
+
+            try:
+                output.write(amplitude_values.tostring())
+                output.flush()
+            except IOError:
+                # reader has already decided and closed stream
+                break
+
+        audio_stream.stop_stream()
+        audio_stream.close()
+        sys.stderr.write('Done recording.\n')
+
     def save(self, frames, filepath_to_save='/home/kolegor/Code/VAS/data/_last_recorded.wav'):        
         waveFile = wave.open(filepath_to_save, 'wb')
         waveFile.setnchannels(self.channels)
@@ -52,5 +81,12 @@ def record(seconds=10, return_frames=False):
     return frames if return_frames else 0
 
 
+def stream(seconds=10):
+    Recorder().stream(sys.stdout, seconds=seconds)
+
+
 if __name__ == '__main__':
-    record()
+    if len(sys.argv) > 1 and sys.argv[1] == 'stream':
+        stream()
+    else:
+        record()
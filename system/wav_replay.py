@@ -0,0 +1,71 @@
+import audioop
+import sys
+import time
+import wave
+
+
+class Replayer:
+
+    """
+    Stand-in for 'wav_record.py stream' without microphone: writes samples of wav files
+    to output (raw 16 bit little endian mono) at real-time rate, as if they were being recorded.
+
+    Usage: python system/wav_replay.py [--speed=<factor>] file.wav [file.wav ...] | system/executable listen ...
+    """
+
+    def __init__(self, chunk=1024, speed=1.0):
+        self.chunk = chunk
+        self.speed = speed
+
+    def replay(self, filepath, output):
+        """
+        :param filepath: wav file (16 bit). Stereo files are mixed down to mono
+        :param output: file-like object to write samples to
+        :return: False if output was closed (reader does not need more samples)
+        """
+        wav_file = wave.open(filepath, 'rb')
+        if wav_file.getsampwidth() != 2:
+            raise ValueError('Only 16 bit wav files can be replayed: {}'.format(filepath))
+
+        rate = wav_file.getframerate()
+        channels = wav_file.getnchannels()
+        start_time = time.time()
+        samples_written = 0
+
+        while True:
+            data = wav_file.readframes(self.chunk)
+            if not data:
+                break
+            if channels > 1:
+                data = audioop.tomono(data, 2, 0.5, 0.5)
+
+            # wait until this chunk would have been recorded
+            delay = start_time + float(samples_written) / (rate * self.speed) - time.time()
+            if delay > 0:
+                time.sleep(delay)
+
+            try:
+                output.write(data)
+                output.flush()
+            except IOError:
+                wav_file.close()
+                return False
+            samples_written += len(data) / 2
+
+        wav_file.close()
+        return True
+
+
+if __name__ == '__main__':
+    speed = 1.0
+    filepaths = []
+    for argument in sys.argv[1:]:
+        if argument.startswith('--speed='):
+            speed = float(argument[len('--speed='):])
+        else:
+            filepaths.append(argument)
+
+    replayer = Replayer(speed=speed)
+    for filepath in filepaths:
+        if not replayer.replay(filepath, sys.stdout):
+            break
@@ -25,6 +25,10 @@ parameters[main_voice_class]=1
 parameters[load_config]=0
 parameters[model]="NN"
 parameters[features_preprocess]=0
+parameters[features_engine]="native"
+parameters[decision]="all"
+parameters[decision_threshold]=0
+parameters[live]=0
 
 
 #
@@ -61,7 +65,10 @@ function run_program_with_parameters(){
         ${parameters[one_vs_all]} \
         ${parameters[main_voice_class]} \
         ${parameters[model]} \
-        ${parameters[features_preprocess]}
+        ${parameters[features_preprocess]} \
+        ${parameters[features_engine]} \
+        ${parameters[decision]} \
+        ${parameters[decision_threshold]}
 }
 
 #  Loading configuration file
@@ -73,22 +80,37 @@ load_config_file
 #   Run system
 #
 
-echo 'SYS: Compiling...'
+# recompile only if sources changed since last compilation
+if [ ! -f system/executable ] || [ -n "$(find system -newer system/executable \( -name '*.cpp' -o -name '*.h' \))" ]; then
+    echo 'SYS: Compiling...'
+    # use FFTW for features FFT if it is installed (see system/source/fft.h)
+    fftw_flags=""
+    if [ -f /usr/include/fftw3.h ]; then
+        fftw_flags="-DVAS_USE_FFTW -lfftw3"
+    fi
+
     g++ -std=c++11 system/main_interface.cpp \
-        -lboost_regex -lboost_filesystem -lboost_system -lm -pthread\
+        -lboost_regex -lboost_filesystem -lboost_system -lm -pthread $fftw_flags\
         -o system/executable
     printf "SYS: Done.\n"
+fi
 
 # Prepare user for recording
 printf "SYS: You will have 5 seconds to record your voice. Recording will start in\n"
 sleep 3
 for i in {3..1}; do echo "$i..." && sleep 1; done
 echo "RECORDING..."
-(python system/wav_record.py "$save_wav_file_path")
-
-# Run classification
-printf "\nSYS: Request to authentication system kernel to classify your voice.\n"
-run_program_with_parameters
+if [ "${parameters[live]}" == "1" ]; then
+    # voice is classified while it is being recorded (no wav file round-trip)
+    parameters[mode]="listen"
+    python system/wav_record.py stream | run_program_with_parameters
+else
+    (python system/wav_record.py "$save_wav_file_path")
+
+    # Run classification
+    printf "\nSYS: Request to authentication system kernel to classify your voice.\n"
+    run_program_with_parameters
+fi
 
 # Check the results
 read -d $'\x04' name < "$path_to_prediction_results"